@@ -74,6 +74,7 @@ libc_common_src_files := \
 	stdio/fileno.c \
 	stdio/findfp.c \
 	stdio/flags.c \
+	stdio/flockfile.c \
 	stdio/fopen.c \
 	stdio/fprintf.c \
 	stdio/fpurge.c \
@@ -227,6 +228,7 @@ libc_common_src_files := \
 	bionic/drand48.c \
 	bionic/eabi.c \
 	bionic/erand48.c \
+	bionic/fork.c \
 	bionic/if_nametoindex.c \
 	bionic/ioctl.c \
 	bionic/ldexp.c \
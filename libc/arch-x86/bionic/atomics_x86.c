@@ -30,6 +30,7 @@
 #define FUTEX_SYSCALL 240
 #define FUTEX_WAIT 0
 #define FUTEX_WAKE 1
+#define FUTEX_CMP_REQUEUE 4
 
 int __futex_wait(volatile void *ftx, int val)
 {
@@ -60,6 +61,32 @@ int __futex_wake(volatile void *ftx, int count)
     return ret;
 }
 
+/* %ebp can't be named as an operand, so the comparison value is passed
+ * in %eax and moved there before loading the syscall number.
+ */
+int __futex_cmp_requeue(volatile void *ftx, int nwake, int nrequeue,
+                        volatile void *ftx2, int val)
+{
+    int ret;
+    asm volatile (
+        "pushl %%ebp;"
+        "movl %%eax, %%ebp;"
+        "movl %1, %%eax;"
+        "int $0x80;"
+        "popl %%ebp;"
+        : "=a" (ret)
+        : "i" (FUTEX_SYSCALL),
+          "0" (val),
+          "b" (ftx),
+          "c" (FUTEX_CMP_REQUEUE),
+          "d" (nwake),
+          "S" (nrequeue),
+          "D" (ftx2)
+        : "memory"
+    );
+    return ret;
+}
+
 int __atomic_cmpxchg(int old, int new, volatile int* addr) {
     int xchg;
     asm volatile (
@@ -102,3 +129,11 @@ int __atomic_inc(volatile int* addr) {
     return old;
 }
 
+
+void __memory_barrier(void) {
+    asm volatile (
+        "lock;"
+        "addl $0, (%%esp);"
+        : : : "memory"
+    );
+}
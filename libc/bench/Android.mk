@@ -0,0 +1,15 @@
+LOCAL_PATH:= $(call my-dir)
+
+#
+# malloc_bench, see the comment at the top of malloc_bench.c
+#
+
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES:= malloc_bench.c
+
+LOCAL_MODULE:= malloc_bench
+
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_EXECUTABLE)
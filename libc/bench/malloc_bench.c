@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * A small malloc()/free() throughput benchmark, used to tune the thread
+ * caches and arenas of dlmalloc.c. Each thread keeps 64 live blocks of
+ * 8 to 127 bytes and keeps replacing a random one, checking that the
+ * previous contents are intact.
+ *
+ * It is built as the malloc_bench test executable, run it on the device:
+ *
+ *   malloc_bench <threads> [<tcache_count> [<arenas>]]
+ *
+ * <tcache_count> is passed to mallopt(M_TCACHE_COUNT), 0 disables the
+ * thread caches. <arenas> is passed to mallopt(M_ARENAS) before any
+ * thread is started. Both are ignored with a warning when the C library
+ * doesn't define them. Results only mean something on SMP hardware with
+ * at least as many cores as threads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <time.h>
+
+#define MAX_THREADS  64
+#define LIVE_BLOCKS  64
+#define ITERATIONS   2000000
+
+static void* worker(void* arg)
+{
+    void*     live[LIVE_BLOCKS];
+    unsigned  r = (unsigned)(size_t)arg * 2654435761U + 1;
+    int       i;
+
+    memset(live, 0, sizeof(live));
+    for (i = 0; i < ITERATIONS; i++) {
+        int     slot;
+        size_t  size;
+
+        r = r * 1103515245U + 12345U;
+        slot = (r >> 8) & (LIVE_BLOCKS - 1);
+        size = 8 + ((r >> 16) % 120);
+
+        if (live[slot] != NULL) {
+            if (((unsigned char*)live[slot])[0] != (unsigned char)slot)
+                abort();
+            free(live[slot]);
+        }
+        live[slot] = malloc(size);
+        if (live[slot] == NULL)
+            abort();
+        memset(live[slot], slot, size);
+    }
+    for (i = 0; i < LIVE_BLOCKS; i++)
+        free(live[i]);
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    pthread_t        threads[MAX_THREADS];
+    struct timespec  start, end;
+    double           seconds;
+    int              n, i;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <threads> [<tcache_count> [<arenas>]]\n",
+                argv[0]);
+        return 1;
+    }
+    n = atoi(argv[1]);
+    if (n < 1 || n > MAX_THREADS) {
+        fprintf(stderr, "%s: 1 to %d threads\n", argv[0], MAX_THREADS);
+        return 1;
+    }
+    if (argc > 2) {
+#ifdef M_TCACHE_COUNT
+        mallopt(M_TCACHE_COUNT, atoi(argv[2]));
+#else
+        fprintf(stderr, "%s: no M_TCACHE_COUNT, ignored\n", argv[0]);
+#endif
+    }
+    if (argc > 3) {
+#ifdef M_ARENAS
+        mallopt(M_ARENAS, atoi(argv[3]));
+#else
+        fprintf(stderr, "%s: no M_ARENAS, ignored\n", argv[0]);
+#endif
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < n; i++)
+        pthread_create(&threads[i], NULL, worker, (void*)(size_t)(i + 1));
+    for (i = 0; i < n; i++)
+        pthread_join(threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    seconds = (end.tv_sec - start.tv_sec) +
+              (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("threads=%d  %.2f Mops/s\n", n, n * (double)ITERATIONS / seconds / 1e6);
+    return 0;
+}
@@ -255,6 +255,22 @@ USE_LOCKS                default: 0 (false)
   pthread or WIN32 mutex lock/unlock. (If set true, this can be
   overridden on a per-mspace basis for mspace versions.)
 
+THREAD_CACHE             default: 1 if USE_LOCKS and ANDROID, else 0
+  If true, small chunks released by free() are kept in a per-thread
+  cache and handed back by the next malloc() of the same size class in
+  that thread, without taking the global lock. Caches are bounded, and
+  flushed back to the global heap when they overflow and when their
+  thread exits. Settable using mallopt(M_TCACHE_COUNT, x) and
+  mallopt(M_TCACHE_MAX, x).
+
+MALLOC_ARENAS            default: same as THREAD_CACHE
+  If true, threads are spread round-robin over up to MAX_ARENAS
+  independent heaps (the global one plus mspaces created on demand), so
+  that threads allocating at the same time do not all wait on a single
+  lock. Implies MSPACES and FOOTERS; the footer of each chunk tells
+  free() which arena it belongs to. The number of arenas defaults to the
+  number of configured CPUs and is settable using mallopt(M_ARENAS, x).
+
 FOOTERS                  default: 0
   If true, provide extra checking and dispatching by placing
   information in the footers of allocated chunks. This adds
@@ -504,6 +520,21 @@ DEFAULT_MMAP_THRESHOLD       default: 256K
 #ifndef ONLY_MSPACES
 #define ONLY_MSPACES 0
 #endif  /* ONLY_MSPACES */
+#ifndef MALLOC_ARENAS
+#if USE_LOCKS && ANDROID && !ONLY_MSPACES
+#define MALLOC_ARENAS 1
+#else   /* USE_LOCKS && ANDROID && !ONLY_MSPACES */
+#define MALLOC_ARENAS 0
+#endif  /* USE_LOCKS && ANDROID && !ONLY_MSPACES */
+#endif  /* MALLOC_ARENAS */
+#if MALLOC_ARENAS
+#ifndef MSPACES
+#define MSPACES 1
+#endif  /* MSPACES */
+#ifndef FOOTERS
+#define FOOTERS 1
+#endif  /* FOOTERS */
+#endif  /* MALLOC_ARENAS */
 #ifndef MSPACES
 #if ONLY_MSPACES
 #define MSPACES 1
@@ -532,6 +563,29 @@ DEFAULT_MMAP_THRESHOLD       default: 256K
 #ifndef USE_LOCKS
 #define USE_LOCKS 0
 #endif  /* USE_LOCKS */
+#ifndef THREAD_CACHE
+#if USE_LOCKS && ANDROID && !ONLY_MSPACES
+#define THREAD_CACHE 1
+#else   /* USE_LOCKS && ANDROID && !ONLY_MSPACES */
+#define THREAD_CACHE 0
+#endif  /* USE_LOCKS && ANDROID && !ONLY_MSPACES */
+#endif  /* THREAD_CACHE */
+#ifndef DEFAULT_TCACHE_COUNT
+#define DEFAULT_TCACHE_COUNT ((size_t)16U)
+#endif  /* DEFAULT_TCACHE_COUNT */
+#ifndef DEFAULT_TCACHE_MAX
+#define DEFAULT_TCACHE_MAX ((size_t)128U)
+#endif  /* DEFAULT_TCACHE_MAX */
+#define TCACHE_MAX_COUNT ((size_t)1024U)
+#if MALLOC_ARENAS && !(THREAD_CACHE && MSPACES && FOOTERS)
+#error "MALLOC_ARENAS requires THREAD_CACHE, MSPACES and FOOTERS"
+#endif  /* MALLOC_ARENAS */
+#ifndef MAX_ARENAS
+#define MAX_ARENAS 8
+#endif  /* MAX_ARENAS */
+#ifndef ARENA_CAPACITY
+#define ARENA_CAPACITY ((size_t)64U * (size_t)1024U)
+#endif  /* ARENA_CAPACITY */
 #ifndef INSECURE
 #define INSECURE 0
 #endif  /* INSECURE */
@@ -612,6 +666,9 @@ DEFAULT_MMAP_THRESHOLD       default: 256K
 #define M_TRIM_THRESHOLD     (-1)
 #define M_GRANULARITY        (-2)
 #define M_MMAP_THRESHOLD     (-3)
+#define M_TCACHE_COUNT       (-4)
+#define M_TCACHE_MAX         (-5)
+#define M_ARENAS             (-6)
 
 /* ------------------------ Mallinfo declarations ------------------------ */
 
@@ -797,6 +854,13 @@ void* dlvalloc(size_t);
   M_TRIM_THRESHOLD     -1   2*1024*1024   any   (MAX_SIZE_T disables)
   M_GRANULARITY        -2     page size   any power of 2 >= page size
   M_MMAP_THRESHOLD     -3      256*1024   any   (or 0 if no MMAP support)
+  M_TCACHE_COUNT       -4            16   0..TCACHE_MAX_COUNT (0 disables)
+  M_TCACHE_MAX         -5           128   0..MAX_SMALL_REQUEST
+  M_ARENAS             -6       # cpus    1..MAX_ARENAS
+
+  M_TCACHE_COUNT is the number of chunks kept per size class in each
+  thread cache, M_TCACHE_MAX the largest request served from them.
+  M_ARENAS only applies to threads that did not allocate yet.
 */
 int dlmallopt(int, int);
 
@@ -1089,6 +1153,11 @@ void  dlmalloc_stats(void);
 
 #if MSPACES
 
+#if MALLOC_ARENAS
+/* mspaces only back libc's own arenas, keep them out of its exports */
+#pragma GCC visibility push(hidden)
+#endif /* MALLOC_ARENAS */
+
 /*
   mspace is an opaque type representing an independent
   region of space that supports mspace_malloc, etc.
@@ -1218,6 +1287,10 @@ int mspace_trim(mspace msp, size_t pad);
 */
 int mspace_mallopt(int, int);
 
+#if MALLOC_ARENAS
+#pragma GCC visibility pop
+#endif /* MALLOC_ARENAS */
+
 #endif /* MSPACES */
 
 #ifdef __cplusplus
@@ -2110,6 +2183,13 @@ struct malloc_params {
   size_t mmap_threshold;
   size_t trim_threshold;
   flag_t default_mflags;
+#if THREAD_CACHE
+  size_t tcache_count;
+  size_t tcache_max;     /* largest chunk size kept in thread caches */
+#endif /* THREAD_CACHE */
+#if MALLOC_ARENAS
+  size_t narenas;        /* 0 until first needed */
+#endif /* MALLOC_ARENAS */
 };
 
 static struct malloc_params mparams;
@@ -2524,6 +2604,10 @@ static int init_mparams(void) {
 
     mparams.mmap_threshold = DEFAULT_MMAP_THRESHOLD;
     mparams.trim_threshold = DEFAULT_TRIM_THRESHOLD;
+#if THREAD_CACHE
+    mparams.tcache_count = DEFAULT_TCACHE_COUNT;
+    mparams.tcache_max = request2size(DEFAULT_TCACHE_MAX);
+#endif /* THREAD_CACHE */
 #if MORECORE_CONTIGUOUS
     mparams.default_mflags = USE_LOCK_BIT|USE_MMAP_BIT;
 #else  /* MORECORE_CONTIGUOUS */
@@ -2611,6 +2695,31 @@ static int change_mparam(int param_number, int value) {
   case M_MMAP_THRESHOLD:
     mparams.mmap_threshold = val;
     return 1;
+#if THREAD_CACHE
+  case M_TCACHE_COUNT:
+    if (val <= TCACHE_MAX_COUNT) {
+      mparams.tcache_count = val;
+      return 1;
+    }
+    else
+      return 0;
+  case M_TCACHE_MAX:
+    if (val <= MAX_SMALL_REQUEST) {
+      mparams.tcache_max = request2size(val);
+      return 1;
+    }
+    else
+      return 0;
+#endif /* THREAD_CACHE */
+#if MALLOC_ARENAS
+  case M_ARENAS:
+    if (val >= 1 && val <= MAX_ARENAS) {
+      mparams.narenas = val;
+      return 1;
+    }
+    else
+      return 0;
+#endif /* MALLOC_ARENAS */
   default:
     return 0;
   }
@@ -4177,7 +4286,16 @@ static void** ialloc(mstate m,
 
 #if !ONLY_MSPACES
 
-void* dlmalloc(size_t bytes) {
+#if THREAD_CACHE
+/* with thread caches, dlmalloc and dlfree are defined further below */
+static void* global_malloc(size_t);
+static void global_free(void*);
+#else /* THREAD_CACHE */
+#define global_malloc dlmalloc
+#define global_free   dlfree
+#endif /* THREAD_CACHE */
+
+void* global_malloc(size_t bytes) {
   /*
      Basic algorithm:
      If a small request (< 256 bytes minus per-chunk overhead):
@@ -4309,7 +4427,7 @@ void* dlmalloc(size_t bytes) {
   return 0;
 }
 
-void dlfree(void* mem) {
+void global_free(void* mem) {
   /*
      Consolidate freed chunks with preceeding or succeeding bordering
      free chunks, if they exist, and then place in a bin.  Intermixed
@@ -4409,6 +4527,187 @@ void dlfree(void* mem) {
 #endif /* FOOTERS */
 }
 
+/* ---------------------------- thread caches ---------------------------- */
+
+#if THREAD_CACHE
+
+/*
+  Each thread gets a small array of singly-linked lists of free chunks,
+  one per small bin size, stored in the TLS_SLOT_MALLOC slot. Chunks
+  sitting in a cache are still marked in use as far as the global heap
+  is concerned; the list link is kept in their first payload word, and
+  the second one holds the address of the cache. free() only walks the
+  list to look for a double free when it finds that marker, and malloc()
+  clears it.
+
+  free() pushes chunks of at most mparams.tcache_max bytes on the list
+  of their size, and when a list already holds mparams.tcache_count
+  chunks, half of them are handed back to the global heap first. malloc()
+  pops from the list matching the padded request size, and falls back
+  to the global heap on a miss. Both fast paths are lock-free.
+
+  __malloc_thread_exit() is called by pthread_exit() after the TLS
+  destructors ran, flushes the cache and marks the slot so that any
+  later call in this thread goes straight to the global heap.
+
+  With MALLOC_ARENAS, the same per-thread structure records the arena
+  the thread allocates from. Arenas are handed out round-robin when the
+  structure is created; arena 0 is the global heap, the others are
+  mspaces created the first time they are assigned. A chunk cached by
+  one thread may come from another thread's arena; free() and cache
+  flushes always return it to its owner, found in the chunk footer.
+*/
+
+#include <sys/tls.h>
+#if MALLOC_ARENAS
+#include <sys/atomics.h>
+#endif /* MALLOC_ARENAS */
+
+#define TCACHE_EXITED     ((struct tcache*)-1)
+#define TCACHE_SLOT       (((void**)__get_tls())[TLS_SLOT_MALLOC])
+
+struct tcache {
+  void*           bins[NSMALLBINS];
+  unsigned short  counts[NSMALLBINS];
+#if MALLOC_ARENAS
+  mstate          arena;
+#endif /* MALLOC_ARENAS */
+};
+
+#if MALLOC_ARENAS
+
+static mstate arenas[MAX_ARENAS];      /* arenas[0] stays 0, meaning gm */
+static volatile int arena_next;
+static MLOCK_T arena_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static mstate arena_select(void) {
+  size_t n = mparams.narenas;
+  size_t i;
+  mstate a;
+
+  if (n == 0) {
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    n = (ncpus < 1)? 1 : (ncpus > MAX_ARENAS)? MAX_ARENAS : (size_t)ncpus;
+    mparams.narenas = n;
+  }
+  i = (unsigned)__atomic_inc(&arena_next) % n;
+  if (i == 0)
+    return gm;
+
+  a = arenas[i];
+  if (a == 0) {
+    ACQUIRE_LOCK(&arena_mutex);
+    if ((a = arenas[i]) == 0)
+      a = arenas[i] = (mstate)create_mspace(ARENA_CAPACITY, 1);
+    RELEASE_LOCK(&arena_mutex);
+  }
+  return (a != 0)? a : gm;
+}
+
+#endif /* MALLOC_ARENAS */
+
+static struct tcache* tcache_create(void) {
+  struct tcache* tc = (struct tcache*)global_malloc(sizeof(struct tcache));
+  if (tc != 0) {
+    memset(tc, 0, sizeof(struct tcache));
+#if MALLOC_ARENAS
+    tc->arena = arena_select();
+#endif /* MALLOC_ARENAS */
+    TCACHE_SLOT = tc;
+  }
+  return tc;
+}
+
+/* give back the first 'n' chunks of a bin to the global heap */
+static void tcache_flush_bin(struct tcache* tc, bindex_t idx, size_t n) {
+  void* mem = tc->bins[idx];
+  while (n-- != 0 && mem != 0) {
+    void* next = *(void**)mem;
+    global_free(mem);
+    tc->counts[idx]--;
+    mem = next;
+  }
+  tc->bins[idx] = mem;
+}
+
+void* dlmalloc(size_t bytes) {
+  struct tcache* tc = (struct tcache*)TCACHE_SLOT;
+  if (tc == 0)
+    tc = tcache_create();
+  if (tc != 0 && tc != TCACHE_EXITED) {
+    if (bytes <= MAX_SMALL_REQUEST) {
+      size_t nb = request2size(bytes);
+      if (nb <= mparams.tcache_max) {
+        bindex_t idx = small_index(nb);
+        void* mem = tc->bins[idx];
+        if (mem != 0) {
+          tc->bins[idx] = *(void**)mem;
+          tc->counts[idx]--;
+          ((void**)mem)[1] = 0;
+          return mem;
+        }
+      }
+    }
+#if MALLOC_ARENAS
+    if (tc->arena != gm) {
+      void* mem = mspace_malloc(tc->arena, bytes);
+      if (mem != 0)
+        return mem;
+    }
+#endif /* MALLOC_ARENAS */
+  }
+  return global_malloc(bytes);
+}
+
+void dlfree(void* mem) {
+  if (mem != 0) {
+    mchunkptr p = mem2chunk(mem);
+    size_t psize = chunksize(p);
+    if (psize <= mparams.tcache_max && ok_cinuse(p) && !is_mmapped(p)) {
+      struct tcache* tc = (struct tcache*)TCACHE_SLOT;
+      if (tc != 0 && tc != TCACHE_EXITED && mparams.tcache_count != 0) {
+        bindex_t idx = small_index(psize);
+        if (((void**)mem)[1] == (void*)tc) {
+          /* probably already in the cache, make sure */
+          void* q;
+          for (q = tc->bins[idx]; q != 0; q = *(void**)q) {
+            if (q == mem) {
+              USAGE_ERROR_ACTION(gm, p);
+              return;
+            }
+          }
+        }
+        if (tc->counts[idx] >= mparams.tcache_count)
+          tcache_flush_bin(tc, idx, (tc->counts[idx] + 1) / 2);
+        *(void**)mem = tc->bins[idx];
+        ((void**)mem)[1] = (void*)tc;
+        tc->bins[idx] = mem;
+        tc->counts[idx]++;
+        return;
+      }
+    }
+    global_free(mem);
+  }
+}
+
+void __malloc_thread_exit(void) {
+  struct tcache* tc = (struct tcache*)TCACHE_SLOT;
+  TCACHE_SLOT = TCACHE_EXITED;
+  if (tc != 0 && tc != TCACHE_EXITED) {
+    bindex_t i;
+    for (i = 0; i < NSMALLBINS; ++i)
+      tcache_flush_bin(tc, i, tc->counts[i]);
+    global_free(tc);
+  }
+}
+
+#else /* THREAD_CACHE */
+
+void __malloc_thread_exit(void) {
+}
+
+#endif /* THREAD_CACHE */
+
 void* dlcalloc(size_t n_elements, size_t elem_size) {
   void *mem;
   if (n_elements && MAX_SIZE_T / n_elements < elem_size) {
@@ -4481,11 +4780,28 @@ int dlmalloc_trim(size_t pad) {
     result = sys_trim(gm, pad);
     POSTACTION(gm);
   }
+#if MALLOC_ARENAS
+  {
+    int i;
+    for (i = 1; i < MAX_ARENAS; ++i)
+      if (arenas[i] != 0)
+        result |= mspace_trim(arenas[i], pad);
+  }
+#endif /* MALLOC_ARENAS */
   return result;
 }
 
 size_t dlmalloc_footprint(void) {
+#if MALLOC_ARENAS
+  size_t result = gm->footprint;
+  int i;
+  for (i = 1; i < MAX_ARENAS; ++i)
+    if (arenas[i] != 0)
+      result += arenas[i]->footprint;
+  return result;
+#else /* MALLOC_ARENAS */
   return gm->footprint;
+#endif /* MALLOC_ARENAS */
 }
 
 #if USE_MAX_ALLOWED_FOOTPRINT
@@ -4509,17 +4825,52 @@ void dlmalloc_set_max_allowed_footprint(size_t bytes) {
 #endif
 
 size_t dlmalloc_max_footprint(void) {
+#if MALLOC_ARENAS
+  size_t result = gm->max_footprint;
+  int i;
+  for (i = 1; i < MAX_ARENAS; ++i)
+    if (arenas[i] != 0)
+      result += arenas[i]->max_footprint;
+  return result;
+#else /* MALLOC_ARENAS */
   return gm->max_footprint;
+#endif /* MALLOC_ARENAS */
 }
 
 #if !NO_MALLINFO
 struct mallinfo dlmallinfo(void) {
+#if MALLOC_ARENAS
+  struct mallinfo nm = internal_mallinfo(gm);
+  int i;
+  for (i = 1; i < MAX_ARENAS; ++i) {
+    if (arenas[i] != 0) {
+      struct mallinfo am = internal_mallinfo(arenas[i]);
+      nm.arena    += am.arena;
+      nm.ordblks  += am.ordblks;
+      nm.hblkhd   += am.hblkhd;
+      nm.usmblks  += am.usmblks;
+      nm.uordblks += am.uordblks;
+      nm.fordblks += am.fordblks;
+      nm.keepcost += am.keepcost;
+    }
+  }
+  return nm;
+#else /* MALLOC_ARENAS */
   return internal_mallinfo(gm);
+#endif /* MALLOC_ARENAS */
 }
 #endif /* NO_MALLINFO */
 
 void dlmalloc_stats() {
   internal_malloc_stats(gm);
+#if MALLOC_ARENAS
+  {
+    int i;
+    for (i = 1; i < MAX_ARENAS; ++i)
+      if (arenas[i] != 0)
+        internal_malloc_stats(arenas[i]);
+  }
+#endif /* MALLOC_ARENAS */
 }
 
 size_t dlmalloc_usable_size(void* mem) {
@@ -5002,21 +5353,9 @@ int mspace_mallopt(int param_number, int value) {
 
 #endif /* MSPACES */
 
-#if MSPACES && ONLY_MSPACES
-void mspace_walk_free_pages(mspace msp,
+static void internal_walk_free_pages(mstate m,
     void(*handler)(void *start, void *end, void *arg), void *harg)
 {
-  mstate m = (mstate)msp;
-  if (!ok_magic(m)) {
-    USAGE_ERROR_ACTION(m,m);
-    return;
-  }
-#else
-void dlmalloc_walk_free_pages(void(*handler)(void *start, void *end, void *arg),
-    void *harg)
-{
-  mstate m = (mstate)gm;
-#endif
   if (!PREACTION(m)) {
     if (is_initialized(m)) {
       msegmentptr s = &m->seg;
@@ -5050,30 +5389,42 @@ void dlmalloc_walk_free_pages(void(*handler)(void *start, void *end, void *arg),
   }
 }
 
-
 #if MSPACES && ONLY_MSPACES
-void mspace_walk_heap(mspace msp,
-                      void(*handler)(const void *chunkptr, size_t chunklen,
-                                     const void *userptr, size_t userlen,
-                                     void *arg),
-                      void *harg)
+void mspace_walk_free_pages(mspace msp,
+    void(*handler)(void *start, void *end, void *arg), void *harg)
 {
-  msegmentptr s;
   mstate m = (mstate)msp;
   if (!ok_magic(m)) {
     USAGE_ERROR_ACTION(m,m);
     return;
   }
+  internal_walk_free_pages(m, handler, harg);
+}
 #else
-void dlmalloc_walk_heap(void(*handler)(const void *chunkptr, size_t chunklen,
-                                       const void *userptr, size_t userlen,
-                                       void *arg),
-                        void *harg)
+void dlmalloc_walk_free_pages(void(*handler)(void *start, void *end, void *arg),
+    void *harg)
 {
-  msegmentptr s;
-  mstate m = (mstate)gm;
+  internal_walk_free_pages(gm, handler, harg);
+#if MALLOC_ARENAS
+  {
+    int i;
+    for (i = 1; i < MAX_ARENAS; ++i)
+      if (arenas[i] != 0)
+        internal_walk_free_pages(arenas[i], handler, harg);
+  }
+#endif /* MALLOC_ARENAS */
+}
 #endif
 
+
+static void internal_walk_heap(mstate m,
+    void(*handler)(const void *chunkptr, size_t chunklen,
+                   const void *userptr, size_t userlen,
+                   void *arg),
+    void *harg)
+{
+  msegmentptr s;
+
   s = &m->seg;
   while (s != 0) {
     mchunkptr p = align_as_chunk(s->base);
@@ -5103,6 +5454,38 @@ void dlmalloc_walk_heap(void(*handler)(const void *chunkptr, size_t chunklen,
   }
 }
 
+#if MSPACES && ONLY_MSPACES
+void mspace_walk_heap(mspace msp,
+                      void(*handler)(const void *chunkptr, size_t chunklen,
+                                     const void *userptr, size_t userlen,
+                                     void *arg),
+                      void *harg)
+{
+  mstate m = (mstate)msp;
+  if (!ok_magic(m)) {
+    USAGE_ERROR_ACTION(m,m);
+    return;
+  }
+  internal_walk_heap(m, handler, harg);
+}
+#else
+void dlmalloc_walk_heap(void(*handler)(const void *chunkptr, size_t chunklen,
+                                       const void *userptr, size_t userlen,
+                                       void *arg),
+                        void *harg)
+{
+  internal_walk_heap(gm, handler, harg);
+#if MALLOC_ARENAS
+  {
+    int i;
+    for (i = 1; i < MAX_ARENAS; ++i)
+      if (arenas[i] != 0)
+        internal_walk_heap(arenas[i], handler, harg);
+  }
+#endif /* MALLOC_ARENAS */
+}
+#endif
+
 /* -------------------- Alternative MORECORE functions ------------------- */
 
 /*
@@ -37,6 +37,10 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/atomics.h>
 
 #include <utils/logger.h>
 #include "logd.h"
@@ -45,6 +49,20 @@
 
 #define LOG_BUF_SIZE	1024
 
+/*
+ * Setting BIONIC_LOG_SINK to "file:<path>" or "socket:<path>" (a unix
+ * stream socket) sends the log there instead of to the kernel logger,
+ * e.g. to run on a host without /dev/log.  Records are written as they
+ * would be to the logger device: the priority byte, then the tag and
+ * the message, each NUL-terminated.
+ *
+ * Setting BIONIC_LOG_BUFFERED enables the buffered mode, see below.
+ *
+ * Both are ignored in setuid and setgid programs.
+ */
+#define LOG_SINK_ENV        "BIONIC_LOG_SINK"
+#define LOG_BUFFERED_ENV    "BIONIC_LOG_BUFFERED"
+
 typedef enum {
     LOG_ID_MAIN = 0,
     LOG_ID_RADIO,
@@ -56,15 +74,26 @@ static int (*write_to_log)(log_id_t, struct iovec *vec) = __write_to_log_init;
 static pthread_mutex_t log_init_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static int log_fds[(int)LOG_ID_MAX] = { -1, -1 };
+static int log_to_sink;     /* both log_fds are the same stream */
 
 static int __write_to_log_null(log_id_t log_fd, struct iovec *vec)
 {
     return -1;
 }
 
-static int __write_to_log_kernel(log_id_t log_id, struct iovec *vec)
+static ssize_t log_writev(int fd, struct iovec *vec, int count)
 {
     ssize_t ret;
+
+    do {
+        ret = writev(fd, vec, count);
+    } while (ret < 0 && errno == EINTR);
+
+    return ret;
+}
+
+static int __write_to_log_kernel(log_id_t log_id, struct iovec *vec)
+{
     int log_fd;
 
     if ((int)log_id >= 0 && (int)log_id < (int)LOG_ID_MAX) {
@@ -73,11 +102,358 @@ static int __write_to_log_kernel(log_id_t log_id, struct iovec *vec)
         return EBADF;
     }
 
-    do {
-        ret = writev(log_fd, vec, 3);
-    } while (ret < 0 && errno == EINTR);
+    return log_writev(log_fd, vec, 3);
+}
 
-    return ret;
+/*
+ * Buffered mode.
+ *
+ * Each thread copies its records into its own ring and returns without
+ * making a system call; a background thread drains the rings.  A record
+ * that doesn't fit in the ring is dropped and counted, so callers never
+ * wait for the logger device.  The number of dropped records is logged
+ * once they can be written again.
+ *
+ * The kernel logger takes one record per write, so the flusher still
+ * makes one writev() per record there.  A file or socket sink gets up
+ * to LOG_BATCH_MAX records per writev().
+ *
+ * Records from different threads may be written out of order, and the
+ * kernel logger timestamps them when they are flushed.  Fatal records
+ * are written synchronously, after everything queued before them.
+ *
+ * A child process gets neither the flusher thread nor a usable state of
+ * the locks, so after fork() it goes back to writing directly, and the
+ * records it inherited are left to the parent.
+ */
+#define LOG_RING_SIZE       16384       /* per thread, power of 2 */
+#define LOG_RECORD_MAX      4096        /* larger ones are written directly */
+#define LOG_BATCH_MAX       32          /* records per writev() to a sink */
+
+/* in the ring, each record is a header followed by the payload */
+typedef struct {
+    unsigned short  len;        /* of the payload */
+    unsigned char   log_id;
+    unsigned char   reserved;
+} log_record_t;
+
+#define LOG_RECORD_SIZE(len) \
+    (sizeof(log_record_t) + (((len) + 3) & ~3))
+
+struct log_ring {
+    struct log_ring*  next;
+    volatile int      head;     /* advanced by the owner thread */
+    volatile int      tail;     /* advanced by the flusher */
+    volatile int      dead;     /* the owner thread is gone */
+    char              data[LOG_RING_SIZE];
+};
+
+static int (*write_to_log_direct)(log_id_t, struct iovec *vec);
+
+static pthread_key_t      log_ring_key;
+static struct log_ring*   log_rings;    /* all of them, newest first */
+static pthread_mutex_t    log_rings_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t    log_flush_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int       log_dropped;
+static volatile int       log_flusher_waiting;
+static volatile int       log_wakeup;
+
+/*
+ * Called by producers after publishing, the flusher does the opposite:
+ * it sets log_flusher_waiting and then looks for work.  Each side needs
+ * a full barrier between its store and its load, or both can miss the
+ * other's store and the flusher sleeps on a queued record.
+ */
+static void log_wake_flusher(void)
+{
+    __memory_barrier();
+    if (log_flusher_waiting) {
+        __atomic_inc(&log_wakeup);
+        __futex_wake(&log_wakeup, 1);
+    }
+}
+
+static void log_ring_release(void *arg)
+{
+    struct log_ring*  ring = arg;
+
+    __atomic_swap(1, &ring->dead);
+    log_wake_flusher();
+}
+
+static struct log_ring* log_ring_get(void)
+{
+    struct log_ring*  ring = pthread_getspecific(log_ring_key);
+
+    if (ring == NULL) {
+        /* not malloc(), which may be the one logging */
+        ring = mmap(NULL, sizeof(*ring), PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ring == MAP_FAILED)
+            return NULL;
+
+        pthread_mutex_lock(&log_rings_lock);
+        ring->next = log_rings;
+        log_rings  = ring;
+        pthread_mutex_unlock(&log_rings_lock);
+
+        pthread_setspecific(log_ring_key, ring);
+    }
+    return ring;
+}
+
+static void log_ring_copy(struct log_ring *ring, unsigned pos,
+                          const void *src, size_t len)
+{
+    unsigned  off   = pos & (LOG_RING_SIZE - 1);
+    size_t    first = LOG_RING_SIZE - off;
+
+    if (first > len)
+        first = len;
+    memcpy(ring->data + off, src, first);
+    memcpy(ring->data, (const char *)src + first, len - first);
+}
+
+/* adds the record at 'pos' to 'vec', returns the number of entries used */
+static int log_ring_iovec(struct log_ring *ring, unsigned pos,
+                          struct iovec *vec, log_record_t *rec)
+{
+    unsigned  off;
+    size_t    first;
+
+    memcpy(rec, ring->data + (pos & (LOG_RING_SIZE - 1)), sizeof(*rec));
+    off   = (pos + sizeof(*rec)) & (LOG_RING_SIZE - 1);
+    first = LOG_RING_SIZE - off;
+
+    vec[0].iov_base = ring->data + off;
+    if (first >= rec->len) {
+        vec[0].iov_len = rec->len;
+        return 1;
+    }
+    vec[0].iov_len  = first;
+    vec[1].iov_base = ring->data;
+    vec[1].iov_len  = rec->len - first;
+    return 2;
+}
+
+/*
+ * Write out the records queued in 'ring'.  Called with log_flush_lock
+ * held.  Returns the number of records written.
+ */
+static int log_ring_flush(struct log_ring *ring)
+{
+    struct iovec  vec[2 * LOG_BATCH_MAX];
+    log_record_t  rec;
+    unsigned      tail = (unsigned)ring->tail;
+    unsigned      head = (unsigned)ring->head;
+    int           count = 0, nvec = 0, nrec = 0;
+
+    /* don't read records older than the head we've just seen */
+    __memory_barrier();
+    while (tail != head) {
+        nvec += log_ring_iovec(ring, tail, vec + nvec, &rec);
+        tail += LOG_RECORD_SIZE(rec.len);
+        count++;
+
+        if (!log_to_sink) {
+            if (rec.log_id < (unsigned)LOG_ID_MAX)
+                log_writev(log_fds[rec.log_id], vec, nvec);
+            nvec = 0;
+        } else if (++nrec == LOG_BATCH_MAX) {
+            log_writev(log_fds[LOG_ID_MAIN], vec, nvec);
+            nvec = nrec = 0;
+        }
+    }
+    if (nvec > 0)
+        log_writev(log_fds[LOG_ID_MAIN], vec, nvec);
+
+    /* the space can only be reused once the writes are done */
+    __memory_barrier();
+    __atomic_swap((int)tail, &ring->tail);
+    return count;
+}
+
+/*
+ * Write out everything that is queued, and release the rings of the
+ * threads that exited.  Called with log_flush_lock held.
+ */
+static void log_flush(void)
+{
+    struct log_ring*   ring;
+    struct log_ring**  pnext;
+    int                dropped;
+
+    for (ring = log_rings; ring != NULL; ring = ring->next)
+        log_ring_flush(ring);
+
+    pthread_mutex_lock(&log_rings_lock);
+    pnext = &log_rings;
+    while ((ring = *pnext) != NULL) {
+        if (ring->dead && ring->head == ring->tail) {
+            *pnext = ring->next;
+            munmap(ring, sizeof(*ring));
+        } else {
+            pnext = &ring->next;
+        }
+    }
+    pthread_mutex_unlock(&log_rings_lock);
+
+    dropped = __atomic_swap(0, &log_dropped);
+    if (dropped > 0) {
+        char          buf[64];
+        unsigned char prio = ANDROID_LOG_WARN;
+        struct iovec  vec[3];
+
+        snprintf(buf, sizeof(buf), "%d log messages dropped", dropped);
+        vec[0].iov_base = &prio;
+        vec[0].iov_len  = 1;
+        vec[1].iov_base = "libc";
+        vec[1].iov_len  = sizeof("libc");
+        vec[2].iov_base = buf;
+        vec[2].iov_len  = strlen(buf) + 1;
+        write_to_log_direct(LOG_ID_MAIN, vec);
+    }
+}
+
+static int log_pending(void)
+{
+    struct log_ring*  ring;
+
+    if (log_dropped)
+        return 1;
+    for (ring = log_rings; ring != NULL; ring = ring->next) {
+        if (ring->head != ring->tail || ring->dead)
+            return 1;
+    }
+    return 0;
+}
+
+static void* log_flusher(void *arg)
+{
+    for (;;) {
+        int  wakeup = log_wakeup;
+
+        /*
+         * Producers only wake us up while we are waiting, so we check
+         * for work once more after saying so.
+         */
+        __atomic_swap(1, &log_flusher_waiting);
+        __memory_barrier();
+        if (!log_pending())
+            __futex_wait(&log_wakeup, wakeup, NULL);
+        __atomic_swap(0, &log_flusher_waiting);
+
+        pthread_mutex_lock(&log_flush_lock);
+        log_flush();
+        pthread_mutex_unlock(&log_flush_lock);
+    }
+    return NULL;
+}
+
+static int __write_to_log_buffered(log_id_t log_id, struct iovec *vec)
+{
+    struct log_ring*  ring;
+    log_record_t      rec;
+    size_t            len = vec[0].iov_len + vec[1].iov_len + vec[2].iov_len;
+    unsigned          head, pos;
+    int               i, ret;
+
+    if (*(unsigned char *)vec[0].iov_base >= ANDROID_LOG_FATAL) {
+        /* the process is probably about to die */
+        pthread_mutex_lock(&log_flush_lock);
+        log_flush();
+        ret = write_to_log_direct(log_id, vec);
+        pthread_mutex_unlock(&log_flush_lock);
+        return ret;
+    }
+
+    ring = log_ring_get();
+    if (ring == NULL || len > LOG_RECORD_MAX)
+        return write_to_log_direct(log_id, vec);
+
+    head = (unsigned)ring->head;
+    if (LOG_RECORD_SIZE(len) > LOG_RING_SIZE - (head - (unsigned)ring->tail)) {
+        __atomic_inc(&log_dropped);
+        return -1;
+    }
+
+    rec.len      = (unsigned short)len;
+    rec.log_id   = (unsigned char)log_id;
+    rec.reserved = 0;
+    log_ring_copy(ring, head, &rec, sizeof(rec));
+    pos = head + sizeof(rec);
+    for (i = 0; i < 3; i++) {
+        log_ring_copy(ring, pos, vec[i].iov_base, vec[i].iov_len);
+        pos += vec[i].iov_len;
+    }
+
+    /* publish the record, then see if the flusher needs a kick */
+    __memory_barrier();
+    __atomic_swap((int)(head + LOG_RECORD_SIZE(len)), &ring->head);
+    log_wake_flusher();
+
+    return len;
+}
+
+static int log_buffered_init(void)
+{
+    pthread_attr_t  attr;
+    pthread_t       thread;
+    int             ret;
+
+    if (pthread_key_create(&log_ring_key, log_ring_release) != 0)
+        return -1;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    ret = pthread_create(&thread, &attr, log_flusher, NULL);
+    pthread_attr_destroy(&attr);
+
+    if (ret != 0) {
+        pthread_key_delete(log_ring_key);
+        return -1;
+    }
+    return 0;
+}
+
+/* called by fork() in the child, see the comment above */
+void __libc_log_fork_child(void)
+{
+    if (write_to_log == __write_to_log_buffered)
+        write_to_log = write_to_log_direct;
+}
+
+static const char* log_getenv(const char *name)
+{
+    if (getuid() != geteuid() || getgid() != getegid())
+        return NULL;
+    return getenv(name);
+}
+
+static int log_open_sink(const char *sink)
+{
+    struct sockaddr_un  addr;
+    int                 fd;
+
+    if (!strncmp(sink, "file:", 5))
+        return open(sink + 5, O_WRONLY | O_CREAT | O_APPEND | O_NOFOLLOW,
+                    0644);
+
+    if (strncmp(sink, "socket:", 7) || strlen(sink + 7) >= sizeof(addr.sun_path))
+        return -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, sink + 7);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
 }
 
 static int __write_to_log_init(log_id_t log_id, struct iovec *vec)
@@ -85,17 +461,30 @@ static int __write_to_log_init(log_id_t log_id, struct iovec *vec)
     pthread_mutex_lock(&log_init_lock);
 
     if (write_to_log == __write_to_log_init) {
-        log_fds[LOG_ID_MAIN] = open("/dev/"LOGGER_LOG_MAIN, O_WRONLY);
-        log_fds[LOG_ID_RADIO] = open("/dev/"LOGGER_LOG_RADIO, O_WRONLY);
+        const char*  sink = log_getenv(LOG_SINK_ENV);
+
+        if (sink != NULL) {
+            log_fds[LOG_ID_MAIN]  = log_open_sink(sink);
+            log_fds[LOG_ID_RADIO] = log_fds[LOG_ID_MAIN];
+            log_to_sink = 1;
+        } else {
+            log_fds[LOG_ID_MAIN] = open("/dev/"LOGGER_LOG_MAIN, O_WRONLY);
+            log_fds[LOG_ID_RADIO] = open("/dev/"LOGGER_LOG_RADIO, O_WRONLY);
+        }
 
         write_to_log = __write_to_log_kernel;
 
         if (log_fds[LOG_ID_MAIN] < 0 || log_fds[LOG_ID_RADIO] < 0) {
             close(log_fds[LOG_ID_MAIN]);
-            close(log_fds[LOG_ID_RADIO]);
+            if (!log_to_sink)
+                close(log_fds[LOG_ID_RADIO]);
             log_fds[LOG_ID_MAIN] = -1;
             log_fds[LOG_ID_RADIO] = -1;
             write_to_log = __write_to_log_null;
+        } else if (log_getenv(LOG_BUFFERED_ENV) != NULL) {
+            write_to_log_direct = write_to_log;
+            if (log_buffered_init() == 0)
+                write_to_log = __write_to_log_buffered;
         }
     }
 
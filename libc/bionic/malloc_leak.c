@@ -44,6 +44,8 @@
 #include <sys/select.h>
 #include <sys/types.h>
 #include <sys/system_properties.h>
+#include <sys/atomics.h>
+#include <sys/tls.h>
 
 #include "dlmalloc.h"
 #include "logd.h"
@@ -52,7 +54,9 @@
 // Utilities directly used by Dalvik
 // =============================================================================
 
-#define HASHTABLE_SIZE      1543
+#define HASH_STRIPE_BITS    4
+#define HASH_STRIPES        (1 << HASH_STRIPE_BITS)
+#define HASH_STRIPE_SIZE    64      /* initial slots per stripe */
 #define BACKTRACE_SIZE      32
 /* flag definitions, currently sharing storage with "size" */
 #define SIZE_FLAG_ZYGOTE_CHILD  (1<<31)
@@ -69,7 +73,7 @@ int gMallocLeakZygoteChild = 0;
 
 typedef struct HashEntry HashEntry;
 struct HashEntry {
-    size_t slot;
+    uint32_t hash;
     HashEntry* prev;
     HashEntry* next;
     size_t numEntries;
@@ -79,26 +83,67 @@ struct HashEntry {
     intptr_t backtrace[0];
 };
 
+/*
+ * The backtrace table is split in HASH_STRIPES independent stripes, picked
+ * by the low bits of the hash, so that threads recording different call
+ * sites rarely wait for each other. Each stripe has its own lock and its
+ * own power-of-two array of slots, which doubles when the stripe holds more
+ * entries than slots. An all-zero pthread_mutex_t is a valid initialized
+ * mutex, so the static array needs no initializer.
+ */
 typedef struct HashTable HashTable;
 struct HashTable {
+    pthread_mutex_t lock;
     size_t count;
-    HashEntry* slots[HASHTABLE_SIZE];
+    size_t size;
+    HashEntry** slots;
 };
 
-static pthread_mutex_t gAllocationsMutex = PTHREAD_MUTEX_INITIALIZER;
-static HashTable gHashTable;
+static HashTable gHashTables[HASH_STRIPES];
+
+/*
+ * Mean number of bytes between two recorded allocations when the heap is
+ * sampled (libc.debug.malloc=20), 0 when every allocation is recorded.
+ */
+static size_t gSampleInterval;
 
 // =============================================================================
 // output fucntions
 // =============================================================================
 
+/*
+ * Estimate how many live allocations a hash entry stands for. When sampling,
+ * an allocation of "size" bytes is recorded with probability 1 - e^(-x),
+ * x = size / gSampleInterval, and always when x >= 1. The probability is
+ * computed with a 5-term series in 8.24 fixed point.
+ */
+static size_t scaled_allocations(HashEntry* entry)
+{
+    size_t size = entry->size & ~SIZE_FLAG_MASK;
+    if (gSampleInterval == 0 || size >= gSampleInterval) {
+        return entry->allocations;
+    }
+
+    const uint64_t one = 1 << 24;
+    uint64_t x = ((uint64_t)size << 24) / gSampleInterval;
+    uint64_t t = one - x / 5;
+    t = one - ((x * t) >> 24) / 4;
+    t = one - ((x * t) >> 24) / 3;
+    t = one - ((x * t) >> 24) / 2;
+    uint64_t p = (x * t) >> 24;
+    if (p == 0) {
+        return entry->allocations;
+    }
+    return (size_t)(((uint64_t)entry->allocations << 24) / p);
+}
+
 static int hash_entry_compare(const void* arg1, const void* arg2)
 {
     HashEntry* e1 = *(HashEntry**)arg1;
     HashEntry* e2 = *(HashEntry**)arg2;
 
-    size_t nbAlloc1 = e1->allocations;
-    size_t nbAlloc2 = e2->allocations;
+    size_t nbAlloc1 = scaled_allocations(e1);
+    size_t nbAlloc2 = scaled_allocations(e2);
     size_t size1 = e1->size & ~SIZE_FLAG_MASK;
     size_t size2 = e2->size & ~SIZE_FLAG_MASK;
     size_t alloc1 = nbAlloc1 * size1;
@@ -146,9 +191,14 @@ void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
         return;
     }
 
-    pthread_mutex_lock(&gAllocationsMutex);
+    size_t total = 0;
+    int i;
+    for (i = 0 ; i < HASH_STRIPES ; i++) {
+        pthread_mutex_lock(&gHashTables[i].lock);
+        total += gHashTables[i].count;
+    }
 
-    if (gHashTable.count == 0) {
+    if (total == 0) {
         *info = NULL;
         *overallSize = 0;
         *infoSize = 0;
@@ -157,29 +207,32 @@ void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
         goto done;
     }
     
-    void** list = (void**)dlmalloc(sizeof(void*) * gHashTable.count);
+    void** list = (void**)dlmalloc(sizeof(void*) * total);
 
-    // debug_log("*****\ngHashTable.count = %d\n", gHashTable.count);
+    // debug_log("*****\ntotal = %d\n", total);
     // debug_log("list = %p\n", list);
 
     // get the entries into an array to be sorted
     int index = 0;
-    int i;
-    for (i = 0 ; i < HASHTABLE_SIZE ; i++) {
-        HashEntry* entry = gHashTable.slots[i];
-        while (entry != NULL) {
-            list[index] = entry;
-            *totalMemory = *totalMemory +
-                ((entry->size & ~SIZE_FLAG_MASK) * entry->allocations);
-            index++;
-            entry = entry->next;
+    for (i = 0 ; i < HASH_STRIPES ; i++) {
+        HashTable* table = &gHashTables[i];
+        size_t j;
+        for (j = 0 ; j < table->size ; j++) {
+            HashEntry* entry = table->slots[j];
+            while (entry != NULL) {
+                list[index] = entry;
+                *totalMemory = *totalMemory +
+                    ((entry->size & ~SIZE_FLAG_MASK) * scaled_allocations(entry));
+                index++;
+                entry = entry->next;
+            }
         }
     }
 
     // debug_log("sorted list!\n");
     // XXX: the protocol doesn't allow variable size for the stack trace (yet)
     *infoSize = (sizeof(size_t) * 2) + (sizeof(intptr_t) * BACKTRACE_SIZE);
-    *overallSize = *infoSize * gHashTable.count;
+    *overallSize = *infoSize * total;
     *backtraceSize = BACKTRACE_SIZE;
 
     // debug_log("infoSize = 0x%x overall = 0x%x\n", *infoSize, *overallSize);
@@ -193,10 +246,10 @@ void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
     }
 
     // debug_log("sorting list...\n");
-    qsort((void*)list, gHashTable.count, sizeof(void*), hash_entry_compare);
+    qsort((void*)list, total, sizeof(void*), hash_entry_compare);
 
     uint8_t* head = *info;
-    const int count = gHashTable.count;
+    const int count = total;
     for (i = 0 ; i < count ; i++) {
         HashEntry* entry = list[i];
         size_t entrySize = (sizeof(size_t) * 2) + (sizeof(intptr_t) * entry->numEntries);
@@ -209,6 +262,7 @@ void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
             entrySize = *infoSize;
         }
         memcpy(head, &(entry->size), entrySize);
+        ((size_t*)head)[1] = scaled_allocations(entry);
         head += *infoSize;
     }
 
@@ -216,7 +270,9 @@ void get_malloc_leak_info(uint8_t** info, size_t* overallSize,
 
 done:
     // debug_log("+++++ done!\n");
-    pthread_mutex_unlock(&gAllocationsMutex);
+    for (i = HASH_STRIPES - 1 ; i >= 0 ; i--) {
+        pthread_mutex_unlock(&gHashTables[i].lock);
+    }
 }
 
 void free_malloc_leak_info(uint8_t* info)
@@ -255,6 +311,9 @@ struct AllocationEntry {
     uint32_t guard;
 };
 
+/* serializes the sentinel checks of the malloc check functions */
+static pthread_mutex_t gAllocationsMutex = PTHREAD_MUTEX_INITIALIZER;
+
 // =============================================================================
 // log funtions
 // =============================================================================
@@ -262,6 +321,74 @@ struct AllocationEntry {
 #define debug_log(format, ...)  \
     __libc_android_log_print(ANDROID_LOG_DEBUG, "malloc_leak", (format), ##__VA_ARGS__ )
 
+// =============================================================================
+// Sampling functions
+// =============================================================================
+
+/*
+ * In sampling mode only a fraction of the allocations are recorded. Each
+ * thread counts down the bytes it allocates in TLS_SLOT_MALLOC_SAMPLE, and
+ * the allocation that crosses zero gets a backtrace. The distance between
+ * two samples is drawn from an exponential distribution, so the sampling
+ * is a Poisson process over the allocated bytes and does not lock onto
+ * periodic allocation patterns. Allocations of at least gSampleInterval
+ * bytes are always recorded.
+ *
+ * The hash table counts the recorded allocations only; get_malloc_leak_info()
+ * scales them back up, see scaled_allocations().
+ */
+
+#define SAMPLE_INTERVAL_DEFAULT     (512 * 1024)
+#define SAMPLE_INTERVAL_MAX         (16 * 1024 * 1024)
+
+static volatile int gSampleSeed;
+
+static uint32_t sample_random()
+{
+    int old, new;
+    do {
+        old = gSampleSeed;
+        new = (int)((uint32_t)old * 1103515245u + 12345u);
+    } while (__atomic_cmpxchg(old, new, &gSampleSeed));
+    return (uint32_t)new;
+}
+
+static intptr_t sample_next_interval()
+{
+    /*
+     * -ln(u) * gSampleInterval, with u uniform in (0, 1] taken from the top
+     * 26 bits of the generator. The logarithm is computed in 16.16 fixed
+     * point, with log2(1 + f) ~= f + 0.346 * f * (1 - f) between powers
+     * of two.
+     */
+    uint32_t r = (sample_random() >> 6) + 1;
+    int e = 31 - __builtin_clz(r);
+    uint32_t f = ((r << (31 - e)) >> 15) & 0xffff;
+    f += (((f * (65536 - f)) >> 16) * 22675) >> 16;
+    uint32_t log2r = (e << 16) + f;
+    uint64_t nlog = ((uint64_t)((26 << 16) - log2r) * 45426) >> 16;   // * ln(2)
+    return (intptr_t)((nlog * gSampleInterval) >> 16) + 1;
+}
+
+static int sample_should_record(size_t bytes)
+{
+    intptr_t* left = (intptr_t*)&((void**)__get_tls())[TLS_SLOT_MALLOC_SAMPLE];
+
+    if (*left == 0) {
+        // first allocation in this thread
+        *left = sample_next_interval();
+    }
+    if (bytes >= gSampleInterval) {
+        return 1;
+    }
+    *left -= (intptr_t)bytes;
+    if (*left > 0) {
+        return 0;
+    }
+    *left = sample_next_interval();
+    return 1;
+}
+
 // =============================================================================
 // Hash Table functions
 // =============================================================================
@@ -269,16 +396,68 @@ static uint32_t get_hash(intptr_t* backtrace, size_t numEntries)
 {
     if (backtrace == NULL) return 0;
 
-    int hash = 0;
+    uint32_t hash = 0;
     size_t i;
     for (i = 0 ; i < numEntries ; i++) {
         hash = (hash * 33) + (backtrace[i] >> 2);
     }
 
+    // mix the high bits down, both the stripe and the slot use the low ones
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
     return hash;
 }
 
-static HashEntry* find_entry(HashTable* table, int slot,
+static inline HashTable* get_stripe(uint32_t hash)
+{
+    return &gHashTables[hash & (HASH_STRIPES - 1)];
+}
+
+static inline size_t get_slot(HashTable* table, uint32_t hash)
+{
+    return (hash >> HASH_STRIPE_BITS) & (table->size - 1);
+}
+
+/*
+ * Double the number of slots of a stripe, or allocate the first ones.
+ * Called with the stripe locked. Returns -1 if the new array can't be
+ * allocated, in which case the stripe keeps its current one; that only
+ * makes the chains longer, unless the stripe has no slots yet.
+ */
+static int grow_stripe(HashTable* table)
+{
+    size_t size = table->size ? table->size * 2 : HASH_STRIPE_SIZE;
+    HashEntry** slots = (HashEntry**)dlcalloc(size, sizeof(HashEntry*));
+    if (slots == NULL) {
+        return -1;
+    }
+
+    HashEntry** old = table->slots;
+    size_t oldSize = table->size;
+    table->slots = slots;
+    table->size = size;
+
+    size_t i;
+    for (i = 0 ; i < oldSize ; i++) {
+        HashEntry* entry = old[i];
+        while (entry != NULL) {
+            HashEntry* next = entry->next;
+            size_t slot = get_slot(table, entry->hash);
+            entry->prev = NULL;
+            entry->next = slots[slot];
+            if (entry->next != NULL) {
+                entry->next->prev = entry;
+            }
+            slots[slot] = entry;
+            entry = next;
+        }
+    }
+    dlfree(old);
+    return 0;
+}
+
+static HashEntry* find_entry(HashTable* table, size_t slot,
         intptr_t* backtrace, size_t numEntries, size_t size)
 {
     HashEntry* entry = table->slots[slot];
@@ -300,10 +479,16 @@ static HashEntry* find_entry(HashTable* table, int slot,
     return NULL;
 }
 
+/*
+ * Count one more allocation for this backtrace and size. Takes the lock of
+ * the stripe the backtrace hashes to, the unwinding is left to the caller
+ * so that it happens outside of any lock. Returns NULL if the entry can't
+ * be allocated.
+ */
 static HashEntry* record_backtrace(intptr_t* backtrace, size_t numEntries, size_t size)
 {
-    size_t hash = get_hash(backtrace, numEntries);
-    size_t slot = hash % HASHTABLE_SIZE;
+    uint32_t hash = get_hash(backtrace, numEntries);
+    HashTable* table = get_stripe(hash);
 
     if (size & SIZE_FLAG_MASK) {
         debug_log("malloc_debug: allocation %zx exceeds bit width\n", size);
@@ -313,56 +498,79 @@ static HashEntry* record_backtrace(intptr_t* backtrace, size_t numEntries, size_
     if (gMallocLeakZygoteChild)
         size |= SIZE_FLAG_ZYGOTE_CHILD;
 
-    HashEntry* entry = find_entry(&gHashTable, slot, backtrace, numEntries, size);
+    pthread_mutex_lock(&table->lock);
+
+    if (table->count >= table->size) {
+        if (grow_stripe(table) < 0 && table->size == 0) {
+            pthread_mutex_unlock(&table->lock);
+            return NULL;
+        }
+    }
+
+    size_t slot = get_slot(table, hash);
+    HashEntry* entry = find_entry(table, slot, backtrace, numEntries, size);
 
     if (entry != NULL) {
         entry->allocations++;
     } else {
         // create a new entry
         entry = (HashEntry*)dlmalloc(sizeof(HashEntry) + numEntries*sizeof(intptr_t));
+        if (entry == NULL) {
+            pthread_mutex_unlock(&table->lock);
+            return NULL;
+        }
         entry->allocations = 1;
-        entry->slot = slot;
+        entry->hash = hash;
         entry->prev = NULL;
-        entry->next = gHashTable.slots[slot];
+        entry->next = table->slots[slot];
         entry->numEntries = numEntries;
         entry->size = size;
 
         memcpy(entry->backtrace, backtrace, numEntries * sizeof(intptr_t));
 
-        gHashTable.slots[slot] = entry;
+        table->slots[slot] = entry;
 
         if (entry->next != NULL) {
             entry->next->prev = entry;
         }
 
         // we just added an entry, increase the size of the hashtable
-        gHashTable.count++;
+        table->count++;
     }
 
+    pthread_mutex_unlock(&table->lock);
     return entry;
 }
 
 static int is_valid_entry(HashEntry* entry)
 {
+    int valid = 0;
     if (entry != NULL) {
         int i;
-        for (i = 0 ; i < HASHTABLE_SIZE ; i++) {
-            HashEntry* e1 = gHashTable.slots[i];
-
-            while (e1 != NULL) {
-                if (e1 == entry) {
-                    return 1;
+        for (i = 0 ; i < HASH_STRIPES && !valid ; i++) {
+            HashTable* table = &gHashTables[i];
+            size_t j;
+            pthread_mutex_lock(&table->lock);
+            for (j = 0 ; j < table->size && !valid ; j++) {
+                HashEntry* e1 = table->slots[j];
+
+                while (e1 != NULL) {
+                    if (e1 == entry) {
+                        valid = 1;
+                        break;
+                    }
+
+                    e1 = e1->next;
                 }
-
-                e1 = e1->next;
             }
+            pthread_mutex_unlock(&table->lock);
         }
     }
 
-    return 0;
+    return valid;
 }
 
-static void remove_entry(HashEntry* entry)
+static void remove_entry(HashTable* table, HashEntry* entry)
 {
     HashEntry* prev = entry->prev;
     HashEntry* next = entry->next;
@@ -372,11 +580,32 @@ static void remove_entry(HashEntry* entry)
 
     if (prev == NULL) {
         // we are the head of the list. set the head to be next
-        gHashTable.slots[entry->slot] = entry->next;
+        table->slots[get_slot(table, entry->hash)] = entry->next;
     }
 
     // we just removed and entry, decrease the size of the hashtable
-    gHashTable.count--;
+    table->count--;
+}
+
+/*
+ * Count one less allocation for an entry returned by record_backtrace(),
+ * and drop the entry when it was the last one.
+ */
+static void release_entry(HashEntry* entry)
+{
+    HashTable* table = get_stripe(entry->hash);
+
+    pthread_mutex_lock(&table->lock);
+    entry->allocations--;
+    int last = (entry->allocations <= 0);
+    if (last) {
+        remove_entry(table, entry);
+    }
+    pthread_mutex_unlock(&table->lock);
+
+    if (last) {
+        dlfree(entry);
+    }
 }
 
 
@@ -440,6 +669,12 @@ static void* chk_calloc(size_t n_elements, size_t elem_size);
 static void* chk_realloc(void* oldMem, size_t bytes);
 static void* chk_memalign(size_t alignment, size_t bytes);
 
+static void* sample_malloc(size_t bytes);
+static void  sample_free(void* mem);
+static void* sample_calloc(size_t n_elements, size_t elem_size);
+static void* sample_realloc(void* oldMem, size_t bytes);
+static void* sample_memalign(size_t alignment, size_t bytes);
+
 typedef struct {
     void* (*malloc)(size_t bytes);
     void  (*free)(void* mem);
@@ -453,7 +688,8 @@ static const MallocDebug gMallocEngineTable[] __attribute__((aligned(32))) =
     { dlmalloc,     dlfree,     dlcalloc,       dlrealloc,     dlmemalign },
     { leak_malloc,  leak_free,  leak_calloc,    leak_realloc,  leak_memalign },
     { fill_malloc,  fill_free,  dlcalloc,       fill_realloc,  fill_memalign },
-    { chk_malloc,   chk_free,   chk_calloc,     chk_realloc,   chk_memalign }
+    { chk_malloc,   chk_free,   chk_calloc,     chk_realloc,   chk_memalign },
+    { sample_malloc, sample_free, sample_calloc, sample_realloc, sample_memalign }
 };
 
 enum {
@@ -461,6 +697,7 @@ enum {
     INDEX_LEAK_CHECK,
     INDEX_MALLOC_FILL,
     INDEX_MALLOC_CHECK,
+    INDEX_SAMPLE,
 };
 
 static MallocDebug const * gMallocDispatch = &gMallocEngineTable[INDEX_NORMAL];
@@ -698,20 +935,21 @@ void* leak_malloc(size_t bytes)
 
     void* base = dlmalloc(bytes + sizeof(AllocationEntry));
     if (base != NULL) {
-        pthread_mutex_lock(&gAllocationsMutex);
-
-            intptr_t backtrace[BACKTRACE_SIZE];
-            size_t numEntries = get_backtrace(backtrace, BACKTRACE_SIZE);
-    
-            AllocationEntry* header = (AllocationEntry*)base;
-            header->entry = record_backtrace(backtrace, numEntries, bytes);
-            header->guard = GUARD;
-    
-            // now increment base to point to after our header.
-            // this should just work since our header is 8 bytes.
-            base = (AllocationEntry*)base + 1;
+        intptr_t backtrace[BACKTRACE_SIZE];
+        size_t numEntries = get_backtrace(backtrace, BACKTRACE_SIZE);
+
+        AllocationEntry* header = (AllocationEntry*)base;
+        header->entry = record_backtrace(backtrace, numEntries, bytes);
+        if (header->entry == NULL) {
+            // every allocation must be in the table, see leak_realloc()
+            dlfree(base);
+            return NULL;
+        }
+        header->guard = GUARD;
 
-        pthread_mutex_unlock(&gAllocationsMutex);
+        // now increment base to point to after our header.
+        // this should just work since our header is 8 bytes.
+        base = (AllocationEntry*)base + 1;
     }
 
     return base;
@@ -720,8 +958,6 @@ void* leak_malloc(size_t bytes)
 void leak_free(void* mem)
 {
     if (mem != NULL) {
-        pthread_mutex_lock(&gAllocationsMutex);
-
         // check the guard to make sure it is valid
         AllocationEntry* header = (AllocationEntry*)mem - 1;
         
@@ -734,12 +970,9 @@ void leak_free(void* mem)
         }
         
         if (header->guard == GUARD || is_valid_entry(header->entry)) {
-            // decrement the allocations
-            HashEntry* entry = header->entry;
-            entry->allocations--;
-            if (entry->allocations <= 0) {
-                remove_entry(entry);
-                dlfree(entry);
+            // decrement the allocations, unless this one wasn't sampled
+            if (header->entry != NULL) {
+                release_entry(header->entry);
             }
 
             // now free the memory!
@@ -748,8 +981,6 @@ void leak_free(void* mem)
             debug_log("WARNING bad header guard: '0x%x'! and invalid entry: %p\n",
                     header->guard, header->entry);
         }
-
-        pthread_mutex_unlock(&gAllocationsMutex);
     }
 }
 
@@ -784,11 +1015,11 @@ void* leak_realloc(void* oldMem, size_t bytes)
     return newMem;
 }
 
-void* leak_memalign(size_t alignment, size_t bytes)
+static void* aligned_malloc(void* (*alloc)(size_t), size_t alignment, size_t bytes)
 {
     // we can just use malloc
     if (alignment <= MALLOC_ALIGNMENT)
-        return leak_malloc(bytes);
+        return alloc(bytes);
 
     // need to make sure it's a power of two
     if (alignment & (alignment-1))
@@ -798,7 +1029,7 @@ void* leak_memalign(size_t alignment, size_t bytes)
     // we will align by at least MALLOC_ALIGNMENT bytes
     // and at most alignment-MALLOC_ALIGNMENT bytes
     size_t size = (alignment-MALLOC_ALIGNMENT) + bytes;
-    void* base = leak_malloc(size);
+    void* base = alloc(size);
     if (base != NULL) {
         intptr_t ptr = (intptr_t)base;
         if ((ptr % alignment) == 0)
@@ -815,6 +1046,103 @@ void* leak_memalign(size_t alignment, size_t bytes)
     }
     return base;
 }
+
+void* leak_memalign(size_t alignment, size_t bytes)
+{
+    return aligned_malloc(leak_malloc, alignment, bytes);
+}
+
+// =============================================================================
+// malloc sampling functions
+// =============================================================================
+
+/*
+ * Every allocation carries an AllocationEntry header like in leak_malloc(),
+ * but only the sampled ones point to a hash entry. The others have a NULL
+ * entry and never touch the hash table, and their backtrace is never
+ * taken.
+ */
+static void* sample_alloc(size_t bytes, int record)
+{
+    AllocationEntry* header = (AllocationEntry*)dlmalloc(bytes + sizeof(AllocationEntry));
+    if (header == NULL) {
+        return NULL;
+    }
+    header->entry = NULL;
+    header->guard = GUARD;
+
+    if (record) {
+        intptr_t backtrace[BACKTRACE_SIZE];
+        size_t numEntries = get_backtrace(backtrace, BACKTRACE_SIZE);
+
+        header->entry = record_backtrace(backtrace, numEntries, bytes);
+    }
+    return header + 1;
+}
+
+void* sample_malloc(size_t bytes)
+{
+    return sample_alloc(bytes, sample_should_record(bytes));
+}
+
+void sample_free(void* mem)
+{
+    if (mem != NULL) {
+        AllocationEntry* header = (AllocationEntry*)mem - 1;
+        if (header->guard == GUARD && header->entry == NULL) {
+            dlfree(header);
+        } else {
+            leak_free(mem);
+        }
+    }
+}
+
+void* sample_calloc(size_t n_elements, size_t elem_size)
+{
+    size_t size = n_elements * elem_size;
+    void* ptr = sample_malloc(size);
+    if (ptr != NULL) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+void* sample_realloc(void* oldMem, size_t bytes)
+{
+    if (oldMem == NULL) {
+        return sample_malloc(bytes);
+    }
+    AllocationEntry* header = (AllocationEntry*)oldMem - 1;
+    if (header->guard != GUARD) {
+        return dlrealloc(oldMem, bytes);
+    }
+
+    int record = sample_should_record(bytes);
+    if (header->entry == NULL && !record) {
+        // neither side is in the profile, let dlmalloc grow in place
+        header = (AllocationEntry*)dlrealloc(header, bytes + sizeof(AllocationEntry));
+        return (header != NULL) ? header + 1 : NULL;
+    }
+
+    size_t oldSize;
+    if (header->entry != NULL) {
+        oldSize = header->entry->size & ~SIZE_FLAG_MASK;
+    } else {
+        oldSize = dlmalloc_usable_size(header) - sizeof(AllocationEntry);
+    }
+    void* newMem = sample_alloc(bytes, record);
+    if (newMem != NULL) {
+        size_t copySize = (oldSize <= bytes) ? oldSize : bytes;
+        memcpy(newMem, oldMem, copySize);
+        sample_free(oldMem);
+    }
+    return newMem;
+}
+
+void* sample_memalign(size_t alignment, size_t bytes)
+{
+    return aligned_malloc(sample_malloc, alignment, bytes);
+}
 #endif /* MALLOC_LEAK_CHECK */
 
 // called from libc_init()
@@ -869,6 +1197,21 @@ void malloc_debug_init()
                 __progname, level);
         gMallocDispatch = &gMallocEngineTable[INDEX_MALLOC_CHECK];
         break;
+    case 20:
+        gSampleInterval = SAMPLE_INTERVAL_DEFAULT;
+        if (__system_property_get("libc.debug.malloc.sample", env)) {
+            int interval = atoi(env);
+            if (interval > 0) {
+                gSampleInterval = (interval < SAMPLE_INTERVAL_MAX) ?
+                        interval : SAMPLE_INTERVAL_MAX;
+            }
+        }
+        gSampleSeed = getpid();
+        __libc_android_log_print(ANDROID_LOG_INFO, "libc",
+                "%s using MALLOC_DEBUG = %d (sampling, every %u bytes)\n",
+                __progname, level, gSampleInterval);
+        gMallocDispatch = &gMallocEngineTable[INDEX_SAMPLE];
+        break;
     }
 #endif
 }
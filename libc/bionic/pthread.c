@@ -48,11 +48,14 @@ extern int  __pthread_clone(int (*fn)(void*), void *child_stack, int flags, void
 extern void _exit_with_stack_teardown(void * stackBase, int stackSize, int retCode);
 extern void _exit_thread(int  retCode);
 extern int  __set_errno(int);
+extern pid_t __set_tid_address(int*  tidptr);
+extern void __malloc_thread_exit(void);
 
 void _thread_created_hook(pid_t thread_id) __attribute__((noinline));
 
 #define PTHREAD_ATTR_FLAG_DETACHED      0x00000001
 #define PTHREAD_ATTR_FLAG_USER_STACK    0x00000002
+#define PTHREAD_ATTR_FLAG_CACHED_STACK  0x00000004
 
 #define DEFAULT_STACKSIZE (1024 * 1024)
 #define STACKBASE 0x10000000
@@ -214,13 +217,148 @@ void _init_thread(pthread_internal_t * thread, pid_t kernel_id, pthread_attr_t *
 }
 
 
-/* XXX stacks not reclaimed if thread spawn fails */
-/* XXX stacks address spaces should be reused if available again */
+/* a small cache of thread stacks, used to avoid an mmap()/mprotect()/munmap()
+ * round-trip for each short-lived thread.
+ *
+ * an exiting thread cannot unmap its own stack until it has stopped running
+ * on it, so instead of _exit_with_stack_teardown() it parks the stack in a
+ * free slot, stores its kernel id in the slot's 'tid' field and registers
+ * that field with set_tid_address(). the kernel clears it once the thread is
+ * really gone, and only then can pthread_create() hand the stack to a new
+ * thread with the same (page-rounded) stack size and guard size.
+ *
+ * a child process inherits the slots of threads that were exiting during
+ * fork(), and nobody will ever clear their tids there. fork() calls
+ * __pthread_fork_child() in the child, which drops those stacks.
+ */
+#define STACK_CACHE_SIZE  8
+
+typedef struct {
+    void*          base;        /* NULL if the slot is free */
+    size_t         size;
+    size_t         guard_size;
+    volatile int   tid;         /* non-zero while the previous owner runs */
+} stack_cache_entry_t;
+
+static stack_cache_entry_t  gStackCache[STACK_CACHE_SIZE];
+static pthread_mutex_t      gStackCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+/* called by fork() in the child, which only has the calling thread. the
+ * other threads of the parent may have held mmap_lock or gStackCacheLock,
+ * and the stacks they parked will never be released by the kernel.
+ */
+void __pthread_fork_child(void)
+{
+    int  nn;
+
+    pthread_mutex_init(&mmap_lock, NULL);
+    pthread_mutex_init(&gStackCacheLock, NULL);
+
+    for (nn = 0; nn < STACK_CACHE_SIZE; nn++) {
+        stack_cache_entry_t*  e = &gStackCache[nn];
+
+        if (e->base != NULL && e->tid != 0) {
+            munmap(e->base, e->size);
+            e->base = NULL;
+            e->tid  = 0;
+        }
+    }
+}
+
+static void *stack_cache_get(size_t size, size_t guard_size)
+{
+    void*  stack = NULL;
+    int    nn;
+
+    pthread_mutex_lock(&gStackCacheLock);
+    for (nn = 0; nn < STACK_CACHE_SIZE; nn++) {
+        stack_cache_entry_t*  e = &gStackCache[nn];
+
+        if (e->base != NULL && e->tid == 0 &&
+            e->size == size && e->guard_size == guard_size) {
+            stack   = e->base;
+            e->base = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&gStackCacheLock);
+    return stack;
+}
+
+/* find a slot for a stack, evicting a dead stack of a different shape if
+ * the cache is full. returns NULL if every slot still belongs to a running
+ * thread. must be called with gStackCacheLock held.
+ */
+static stack_cache_entry_t *stack_cache_slot(void)
+{
+    stack_cache_entry_t*  victim = NULL;
+    int                   nn;
+
+    for (nn = 0; nn < STACK_CACHE_SIZE; nn++) {
+        stack_cache_entry_t*  e = &gStackCache[nn];
+
+        if (e->base == NULL)
+            return e;
+        if (victim == NULL && e->tid == 0)
+            victim = e;
+    }
+    if (victim != NULL) {
+        munmap(victim->base, victim->size);
+        victim->base = NULL;
+    }
+    return victim;
+}
+
+/* give back a stack that was never used, e.g. because clone() failed */
+static void stack_cache_put(void *stack, size_t size, size_t guard_size)
+{
+    stack_cache_entry_t*  e;
+
+    pthread_mutex_lock(&gStackCacheLock);
+    e = stack_cache_slot();
+    if (e != NULL) {
+        e->size       = size;
+        e->guard_size = guard_size;
+        e->tid        = 0;
+        e->base       = stack;
+    }
+    pthread_mutex_unlock(&gStackCacheLock);
+
+    if (e == NULL)
+        munmap(stack, size);
+}
+
+/* park the calling thread's stack in the cache. on success the slot's tid
+ * is cleared by the kernel when the thread exits, and the caller must exit
+ * with _exit_thread() without unmapping the stack. returns -1 if the cache
+ * has no room, in which case the caller must tear down the stack itself.
+ */
+static int stack_cache_park(void *stack, size_t size, size_t guard_size, pid_t tid)
+{
+    stack_cache_entry_t*  e;
+
+    pthread_mutex_lock(&gStackCacheLock);
+    e = stack_cache_slot();
+    if (e != NULL) {
+        e->size       = size;
+        e->guard_size = guard_size;
+        e->tid        = tid;
+        e->base       = stack;
+        __set_tid_address((int*)&e->tid);
+    }
+    pthread_mutex_unlock(&gStackCacheLock);
+
+    return (e != NULL) ? 0 : -1;
+}
 
 static void *mkstack(size_t size, size_t guard_size)
 {
     void * stack;
 
+    stack = stack_cache_get(size, guard_size);
+    if (stack != NULL)
+        return stack;
+
     pthread_mutex_lock(&mmap_lock);
 
     stack = mmap((void *)gStackBase, size,
@@ -329,7 +467,7 @@ int pthread_create(pthread_t *thread_out, pthread_attr_t const * attr,
     if(tid < 0) {
         int  result;
         if (madestack)
-            munmap(stack, stackSize);
+            stack_cache_put(stack, stackSize, attr->guard_size);
         _pthread_internal_free(thread);
         result = errno;
         errno = old_errno;
@@ -338,8 +476,11 @@ int pthread_create(pthread_t *thread_out, pthread_attr_t const * attr,
 
     _init_thread(thread, tid, (pthread_attr_t*)attr, stack);
 
+    thread->attr.flags &= ~PTHREAD_ATTR_FLAG_CACHED_STACK;
     if (!madestack)
         thread->attr.flags |= PTHREAD_ATTR_FLAG_USER_STACK;
+    else
+        thread->attr.flags |= PTHREAD_ATTR_FLAG_CACHED_STACK;
 
     // Notify any debuggers about the new thread
     pthread_mutex_lock(&gDebuggerNotificationLock);
@@ -522,7 +663,10 @@ void pthread_exit(void * retval)
     pthread_internal_t*  thread     = __get_thread();
     void*                stack_base = thread->attr.stack_base;
     int                  stack_size = thread->attr.stack_size;
+    size_t               guard_size = thread->attr.guard_size;
+    pid_t                kernel_id  = thread->kernel_id;
     int                  user_stack = (thread->attr.flags & PTHREAD_ATTR_FLAG_USER_STACK) != 0;
+    int                  cache_stack = (thread->attr.flags & PTHREAD_ATTR_FLAG_CACHED_STACK) != 0;
 
     // call the cleanup handlers first
     while (thread->cleanup_stack) {
@@ -537,6 +681,10 @@ void pthread_exit(void * retval)
     // space (see pthread_key_delete)
     pthread_key_clean_all();
 
+    // give this thread's malloc cache back to the global heap, now that the
+    // TLS destructors can't free anything into it anymore
+    __malloc_thread_exit();
+
     // if the thread is detached, destroy the pthread_internal_t
     // otherwise, keep it in memory and signal any joiners
     if (thread->attr.flags & PTHREAD_ATTR_FLAG_DETACHED) {
@@ -565,9 +713,13 @@ void pthread_exit(void * retval)
         pthread_mutex_unlock(&gThreadListLock);
     }
 
-    // destroy the thread stack
+    // destroy the thread stack, or hand it over to the stack cache
     if (user_stack)
         _exit_thread((int)retval);
+    else if (cache_stack && stack_cache_park(stack_base,
+                                             (stack_size + (PAGE_SIZE-1)) & ~(PAGE_SIZE-1),
+                                             guard_size, kernel_id) == 0)
+        _exit_thread((int)retval);
     else
         _exit_with_stack_teardown(stack_base, stack_size, (int)retval);
 }
@@ -710,6 +862,9 @@ int __futex_wake(volatile void *ftx, int count);
  * 15-14     type     mutex type
  * 13-2      counter  counter of recursive mutexes
  * 1-0       state    lock state (0, 1 or 2)
+ *
+ * adaptive mutexes use the same 0/1/2 protocol as normal ones, only with
+ * the type bits set, and spin for a while before sleeping on the futex.
  */
 
 
@@ -720,17 +875,62 @@ int __futex_wake(volatile void *ftx, int count);
 #define  MUTEX_TYPE_NORMAL     0x0000
 #define  MUTEX_TYPE_RECURSIVE  0x4000
 #define  MUTEX_TYPE_ERRORCHECK 0x8000
+#define  MUTEX_TYPE_ADAPTIVE   0xc000
 
 #define  MUTEX_COUNTER_SHIFT  2
 #define  MUTEX_COUNTER_MASK   0x3ffc
 
+/* number of iterations an adaptive mutex spins before sleeping. this is
+ * resolved lazily to 0 on uniprocessor systems, where spinning can only
+ * delay the owner.
+ */
+#define  MUTEX_SPIN_DEFAULT   100
+#define  MUTEX_SPIN_UNKNOWN   -1
+
+static int  gMutexSpinCount   = MUTEX_SPIN_UNKNOWN;
+static int  gMutexDefaultType = PTHREAD_MUTEX_NORMAL;
+
+static struct pthread_mutex_stats_np  gMutexStats;
+
+#if defined(__i386__)
+#  define  MUTEX_SPIN_PAUSE()  __asm__ __volatile__ ("rep; nop" ::: "memory")
+#else
+#  define  MUTEX_SPIN_PAUSE()  __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+int pthread_mutex_setspin_np(int spins)
+{
+    int  old = gMutexSpinCount;
+
+    gMutexSpinCount = (spins < 0) ? MUTEX_SPIN_UNKNOWN : spins;
+    return (old < 0) ? MUTEX_SPIN_DEFAULT : old;
+}
+
+int pthread_mutex_setdefaulttype_np(int type)
+{
+    if (type != PTHREAD_MUTEX_NORMAL && type != PTHREAD_MUTEX_ADAPTIVE_NP)
+        return EINVAL;
+
+    gMutexDefaultType = type;
+    return 0;
+}
+
+void pthread_mutex_getstats_np(struct pthread_mutex_stats_np *stats, int reset)
+{
+    if (stats != NULL)
+        *stats = gMutexStats;
+
+    if (reset)
+        memset(&gMutexStats, 0, sizeof(gMutexStats));
+}
+
 
 
 
 int pthread_mutexattr_init(pthread_mutexattr_t *attr)
 {
     if (attr) {
-        *attr = PTHREAD_MUTEX_DEFAULT;
+        *attr = gMutexDefaultType;
         return 0;
     } else {
         return EINVAL;
@@ -750,7 +950,7 @@ int pthread_mutexattr_destroy(pthread_mutexattr_t *attr)
 int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type)
 {
     if (attr && *attr >= PTHREAD_MUTEX_NORMAL &&
-                *attr <= PTHREAD_MUTEX_ERRORCHECK ) {
+                *attr <= PTHREAD_MUTEX_ADAPTIVE_NP ) {
         *type = *attr;
         return 0;
     }
@@ -760,7 +960,7 @@ int pthread_mutexattr_gettype(const pthread_mutexattr_t *attr, int *type)
 int pthread_mutexattr_settype(pthread_mutexattr_t *attr, int type)
 {
     if (attr && type >= PTHREAD_MUTEX_NORMAL &&
-                type <= PTHREAD_MUTEX_ERRORCHECK ) {
+                type <= PTHREAD_MUTEX_ADAPTIVE_NP ) {
         *attr = type;
         return 0;
     }
@@ -772,7 +972,8 @@ int pthread_mutex_init(pthread_mutex_t *mutex,
 {
     if ( mutex ) {
         if (attr == NULL) {
-            mutex->value = MUTEX_TYPE_NORMAL;
+            mutex->value = (gMutexDefaultType == PTHREAD_MUTEX_ADAPTIVE_NP)
+                         ? MUTEX_TYPE_ADAPTIVE : MUTEX_TYPE_NORMAL;
             return 0;
         }
         switch ( *attr ) {
@@ -787,6 +988,10 @@ int pthread_mutex_init(pthread_mutex_t *mutex,
         case PTHREAD_MUTEX_ERRORCHECK:
             mutex->value = MUTEX_TYPE_ERRORCHECK;
             return 0;
+
+        case PTHREAD_MUTEX_ADAPTIVE_NP:
+            mutex->value = MUTEX_TYPE_ADAPTIVE;
+            return 0;
         }
     }
     return EINVAL;
@@ -896,6 +1101,61 @@ _normal_unlock(pthread_mutex_t*  mutex)
     }
 }
 
+/*
+ * Lock an adaptive mutex.
+ *
+ * This is _normal_lock() with the type bits set in every state, except
+ * that when the first compare-and-swap fails we poll the lock for up to
+ * gMutexSpinCount iterations, hoping that the owner releases it soon,
+ * before promoting it to state 2 and sleeping.  Only plain reads are
+ * done while spinning so that waiters don't bounce the cache line.
+ */
+static void
+_adaptive_lock(pthread_mutex_t*  mutex)
+{
+    const int  unlocked = MUTEX_TYPE_ADAPTIVE;
+    const int  locked   = MUTEX_TYPE_ADAPTIVE | 1;
+    const int  waiters  = MUTEX_TYPE_ADAPTIVE | 2;
+    int        spins;
+
+    if (__atomic_cmpxchg(unlocked, locked, &mutex->value) == 0)
+        return;
+
+    __atomic_inc((int*)&gMutexStats.contended);
+
+    spins = gMutexSpinCount;
+    if (spins < 0) {
+        spins = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? MUTEX_SPIN_DEFAULT : 0;
+        gMutexSpinCount = spins;
+    }
+
+    while (spins-- > 0) {
+        MUTEX_SPIN_PAUSE();
+        if (mutex->value == unlocked &&
+            __atomic_cmpxchg(unlocked, locked, &mutex->value) == 0) {
+            __atomic_inc((int*)&gMutexStats.spin_hits);
+            return;
+        }
+    }
+
+    while (__atomic_swap(waiters, &mutex->value) != unlocked) {
+        __atomic_inc((int*)&gMutexStats.sleeps);
+        __futex_wait(&mutex->value, waiters, 0);
+    }
+}
+
+/*
+ * Release an adaptive mutex, see _normal_unlock().
+ */
+static __inline__ void
+_adaptive_unlock(pthread_mutex_t*  mutex)
+{
+    if (__atomic_dec(&mutex->value) != (MUTEX_TYPE_ADAPTIVE | 1)) {
+        mutex->value = MUTEX_TYPE_ADAPTIVE;
+        __futex_wake(&mutex->value, 1);
+    }
+}
+
 static pthread_mutex_t  __recursive_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static void
@@ -922,6 +1182,9 @@ int pthread_mutex_lock(pthread_mutex_t *mutex)
         if ( __likely(mtype == MUTEX_TYPE_NORMAL) ) {
             _normal_lock(mutex);
         }
+        else if (mtype == MUTEX_TYPE_ADAPTIVE) {
+            _adaptive_lock(mutex);
+        }
         else
         {
             int  tid = __get_thread()->kernel_id;
@@ -996,6 +1259,9 @@ int pthread_mutex_unlock(pthread_mutex_t *mutex)
         if (__likely(mtype == MUTEX_TYPE_NORMAL)) {
             _normal_unlock(mutex);
         }
+        else if (mtype == MUTEX_TYPE_ADAPTIVE) {
+            _adaptive_unlock(mutex);
+        }
         else
         {
             int  tid = __get_thread()->kernel_id;
@@ -1041,6 +1307,14 @@ int pthread_mutex_trylock(pthread_mutex_t *mutex)
 
             return EBUSY;
         }
+        else if (mtype == MUTEX_TYPE_ADAPTIVE)
+        {
+            if (__atomic_cmpxchg(MUTEX_TYPE_ADAPTIVE, MUTEX_TYPE_ADAPTIVE | 1,
+                                 &mutex->value) == 0)
+                return 0;
+
+            return EBUSY;
+        }
         else
         {
             int  tid = __get_thread()->kernel_id;
@@ -1080,13 +1354,116 @@ int pthread_mutex_trylock(pthread_mutex_t *mutex)
 }
 
 
-/* XXX *technically* there is a race condition that could allow
- * XXX a signal to be missed.  If thread A is preempted in _wait()
- * XXX after unlocking the mutex and before waiting, and if other
- * XXX threads call signal or broadcast UINT_MAX times (exactly),
- * XXX before thread A is scheduled again and calls futex_wait(),
- * XXX then the signal will be lost.
+/* the condvar value is a counter in bits 1-31 and a "has waiters" flag
+ * in bit 0. a waiter sets the flag, then sleeps on the value it saw. signal
+ * and broadcast return at once when the flag is clear. otherwise they
+ * change the value before waking anyone, so that a waiter that hasn't
+ * reached futex_wait() yet doesn't go to sleep.
+ *
+ * broadcast clears the flag along with the increment, since every waiter
+ * is woken or requeued. signal keeps it while it finds sleepers. when
+ * futex_wake() finds none, it clears the flag and wakes any thread that
+ * went to sleep in between.
+ *
+ * this narrows the old lost wakeup window. if thread A is preempted between
+ * unlocking the mutex and calling futex_wait(), the value can only come
+ * back to what A saw after about 2^31 other waits, where any number of
+ * signals and broadcasts used to be enough.
+ */
+#define  COND_HAS_WAITERS   1
+#define  COND_COUNTER_STEP  2
+
+
+/* broadcast wakes a single waiter and requeues the others onto the mutex
+ * futex with FUTEX_CMP_REQUEUE, instead of waking them all just to have
+ * them fight over the mutex. since requeued threads can only be woken by
+ * a mutex unlock, waiters always re-acquire the mutex in the "contended"
+ * state. this is only done for normal and adaptive mutexes, the others
+ * don't use a plain 0/1/2 futex word.
+ *
+ * pthread_cond_t has no room to remember the mutex, so waiters record it
+ * in a small table indexed by the condvar address. each slot is guarded
+ * by a sequence number that is odd while the slot is being updated. a
+ * broadcast that finds another condvar in the slot, or races with an
+ * update, just wakes everyone. the table only ever holds addresses from
+ * the calling process, which matters for condvars in shared memory.
+ */
+#define  COND_MUTEX_SLOTS  64
+
+typedef struct {
+    volatile int                seq;
+    pthread_cond_t* volatile    cond;
+    pthread_mutex_t* volatile   mutex;  /* NULL if it can't be requeued to */
+} cond_mutex_slot_t;
+
+static cond_mutex_slot_t  gCondMutex[COND_MUTEX_SLOTS];
+
+static cond_mutex_slot_t *
+_cond_mutex_slot(pthread_cond_t *cond)
+{
+    unsigned  h = ((unsigned)cond >> 2) * 2654435761U;
+
+    return &gCondMutex[h >> 26];
+}
+
+/* record the mutex used by the waiters of 'cond'. this must happen before
+ * the waiter reads the sequence number, so that a broadcast that bumps it
+ * afterwards is sure to find the mutex.
+ *
+ * the atomic operations don't order the plain accesses around them on SMP
+ * ARM, so both sides of the slot's seqlock use explicit barriers.
  */
+static void
+_cond_set_mutex(pthread_cond_t *cond, pthread_mutex_t *mutex)
+{
+    cond_mutex_slot_t*  slot = _cond_mutex_slot(cond);
+    int                 mtype = (mutex->value & MUTEX_TYPE_MASK);
+    int                 seq;
+
+    if (mtype != MUTEX_TYPE_NORMAL && mtype != MUTEX_TYPE_ADAPTIVE)
+        mutex = NULL;
+
+    /* the usual case, nothing to write */
+    if (slot->cond == cond && slot->mutex == mutex)
+        return;
+
+    for (;;) {
+        seq = slot->seq;
+        if (!(seq & 1) && __atomic_cmpxchg(seq, seq + 1, &slot->seq) == 0)
+            break;
+        sched_yield();
+    }
+    __memory_barrier();
+    slot->cond  = cond;
+    slot->mutex = mutex;
+    __memory_barrier();
+    __atomic_swap(seq + 2, &slot->seq);
+
+    /* publish the slot before the caller reads the condvar value */
+    __memory_barrier();
+}
+
+/* returns the mutex to requeue the waiters of 'cond' onto, or NULL */
+static pthread_mutex_t *
+_cond_get_mutex(pthread_cond_t *cond)
+{
+    cond_mutex_slot_t*  slot = _cond_mutex_slot(cond);
+    pthread_mutex_t*    mutex = NULL;
+    int                 seq;
+
+    /* also orders the caller's update of the condvar value before this */
+    __memory_barrier();
+    seq = slot->seq;
+    if (seq & 1)
+        return NULL;
+    __memory_barrier();
+    if (slot->cond == cond)
+        mutex = slot->mutex;
+    __memory_barrier();
+    if (slot->seq != seq)
+        return NULL;
+    return mutex;
+}
 
 int pthread_cond_init(pthread_cond_t *cond,
                       const pthread_condattr_t *attr)
@@ -1101,17 +1478,97 @@ int pthread_cond_destroy(pthread_cond_t *cond)
     return 0;
 }
 
+/* re-acquire the mutex after a wait. we may have been requeued onto its
+ * futex, so we must leave it in the contended state to make sure that
+ * our own unlock wakes up the next requeued thread.
+ */
+static void
+_cond_relock(pthread_mutex_t *mutex)
+{
+    int  mtype = (mutex->value & MUTEX_TYPE_MASK);
+
+    if (mtype == MUTEX_TYPE_NORMAL || mtype == MUTEX_TYPE_ADAPTIVE) {
+        while (__atomic_swap(mtype | 2, &mutex->value) != mtype)
+            __futex_wait(&mutex->value, mtype | 2, 0);
+    } else {
+        pthread_mutex_lock(mutex);
+    }
+}
+
 int pthread_cond_broadcast(pthread_cond_t *cond)
 {
-    __atomic_dec(&cond->value);
+    pthread_mutex_t*  mutex;
+    int               oldvalue, seq;
+
+    do {
+        oldvalue = cond->value;
+        if (!(oldvalue & COND_HAS_WAITERS))
+            return 0;
+        seq = (oldvalue + COND_COUNTER_STEP) & ~COND_HAS_WAITERS;
+    } while (__atomic_cmpxchg(oldvalue, seq, &cond->value) != 0);
+
+    /* the mutex is only read after the sequence number changed. the
+     * requeue fails with EAGAIN if it changed again in the meantime, just
+     * wake everyone in this case */
+    mutex = _cond_get_mutex(cond);
+    if (mutex != NULL &&
+        __futex_cmp_requeue(&cond->value, 1, INT_MAX,
+                            &mutex->value, seq) >= 0)
+        return 0;
+
     __futex_wake(&cond->value, INT_MAX);
     return 0;
 }
 
 int pthread_cond_signal(pthread_cond_t *cond)
 {
-    __atomic_dec(&cond->value);
-    __futex_wake(&cond->value, 1);
+    int  oldvalue, seq;
+
+    do {
+        oldvalue = cond->value;
+        if (!(oldvalue & COND_HAS_WAITERS))
+            return 0;
+        seq = oldvalue + COND_COUNTER_STEP;
+    } while (__atomic_cmpxchg(oldvalue, seq, &cond->value) != 0);
+
+    if (__futex_wake(&cond->value, 1) > 0)
+        return 0;
+
+    /* nobody was asleep. if the value changed since, another signal or
+     * broadcast takes care of it */
+    if (__atomic_cmpxchg(seq, seq & ~COND_HAS_WAITERS, &cond->value) == 0)
+        __futex_wake(&cond->value, INT_MAX);
+    return 0;
+}
+
+/* common part of all wait functions, 'reltime' is a relative timeout or
+ * NULL to wait forever.
+ */
+static int
+_cond_wait_relative(pthread_cond_t *cond, pthread_mutex_t *mutex,
+                    const struct timespec *reltime)
+{
+    int  oldvalue, status;
+
+    _cond_set_mutex(cond, mutex);
+    for (;;) {
+        oldvalue = cond->value;
+        if (oldvalue & COND_HAS_WAITERS)
+            break;
+        if (__atomic_cmpxchg(oldvalue, oldvalue | COND_HAS_WAITERS,
+                             &cond->value) == 0) {
+            oldvalue |= COND_HAS_WAITERS;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(mutex);
+    status = __futex_wait(&cond->value, oldvalue, reltime);
+    _cond_relock(mutex);
+
+    if (status == (-ETIMEDOUT))
+        return ETIMEDOUT;
+
     return 0;
 }
 
@@ -1124,10 +1581,8 @@ int pthread_cond_timedwait(pthread_cond_t *cond,
                            pthread_mutex_t * mutex,
                            const struct timespec *abstime)
 {
-    int oldvalue;
     struct timespec ts;
     struct timespec * tsp;
-    int status;
 
     if (abstime != NULL) {
         clock_gettime(CLOCK_REALTIME, &ts);
@@ -1145,15 +1600,7 @@ int pthread_cond_timedwait(pthread_cond_t *cond,
         tsp = NULL;
     }
 
-    oldvalue = cond->value;
-
-    pthread_mutex_unlock(mutex);
-    status = __futex_wait(&cond->value, oldvalue, tsp);
-    pthread_mutex_lock(mutex);
-
-    if(status == (-ETIMEDOUT)) return ETIMEDOUT;
-
-    return 0;
+    return _cond_wait_relative(cond, mutex, tsp);
 }
 
 
@@ -1161,10 +1608,8 @@ int pthread_cond_timedwait_monotonic(pthread_cond_t *cond,
                                      pthread_mutex_t * mutex,
                                      const struct timespec *abstime)
 {
-    int oldvalue;
     struct timespec ts;
     struct timespec * tsp;
-    int status;
 
     if (abstime != NULL) {
         clock_gettime(CLOCK_MONOTONIC, &ts);
@@ -1182,35 +1627,480 @@ int pthread_cond_timedwait_monotonic(pthread_cond_t *cond,
         tsp = NULL;
     }
 
-    oldvalue = cond->value;
-
-    pthread_mutex_unlock(mutex);
-    status = __futex_wait(&cond->value, oldvalue, tsp);
-    pthread_mutex_lock(mutex);
-
-    if(status == (-ETIMEDOUT)) return ETIMEDOUT;
-
-    return 0;
+    return _cond_wait_relative(cond, mutex, tsp);
 }
 
 int pthread_cond_timeout_np(pthread_cond_t *cond,
                             pthread_mutex_t * mutex,
                             unsigned msecs)
 {
-    int oldvalue;
     struct timespec ts;
-    int status;
 
     ts.tv_sec = msecs / 1000;
     ts.tv_nsec = (msecs % 1000) * 1000000;
 
-    oldvalue = cond->value;
+    return _cond_wait_relative(cond, mutex, &ts);
+}
 
-    pthread_mutex_unlock(mutex);
-    status = __futex_wait(&cond->value, oldvalue, &ts);
-    pthread_mutex_lock(mutex);
+/* converts an absolute CLOCK_REALTIME deadline into the relative timeout
+ * expected by __futex_wait(). returns ETIMEDOUT if it already expired.
+ */
+static int __abstime_to_reltime(const struct timespec *abstime,
+                                struct timespec *reltime)
+{
+    clock_gettime(CLOCK_REALTIME, reltime);
+    reltime->tv_sec = abstime->tv_sec - reltime->tv_sec;
+    reltime->tv_nsec = abstime->tv_nsec - reltime->tv_nsec;
+    if (reltime->tv_nsec < 0) {
+        reltime->tv_sec--;
+        reltime->tv_nsec += 1000000000;
+    }
+    if ((reltime->tv_nsec < 0) || (reltime->tv_sec < 0))
+        return ETIMEDOUT;
+    return 0;
+}
+
+
+/* rwlock states
+ *
+ *  0: unlocked
+ * -1: write-locked, 'writer_tid' holds the owner's kernel id
+ *  n: read-locked by n readers
+ *
+ * waiters register themselves in 'pending_readers' / 'pending_writers'
+ * and sleep on 'reader_wakeup' / 'writer_wakeup'. a waiter samples the
+ * wakeup counter *before* registering and re-checking the state, and a
+ * releaser bumps the counter *after* changing the state, so a release
+ * that races with a waiter going to sleep makes its __futex_wait()
+ * return immediately instead of being lost.
+ *
+ * writers have priority: readers don't enter while a writer is pending,
+ * and a release wakes the writers if there are any, readers otherwise.
+ * all waiters of the chosen kind are woken; they then race for the lock
+ * and the losers go back to sleep. this avoids handing a wakeup to a
+ * waiter that is just timing out.
+ */
+
+int pthread_rwlockattr_init(pthread_rwlockattr_t *attr)
+{
+    if (attr) {
+        *attr = PTHREAD_PROCESS_PRIVATE;
+        return 0;
+    } else {
+        return EINVAL;
+    }
+}
+
+int pthread_rwlockattr_destroy(pthread_rwlockattr_t *attr)
+{
+    if (attr) {
+        *attr = -1;
+        return 0;
+    } else {
+        return EINVAL;
+    }
+}
+
+int pthread_rwlockattr_getpshared(const pthread_rwlockattr_t *attr, int *pshared)
+{
+    if (attr && (*attr == PTHREAD_PROCESS_PRIVATE ||
+                 *attr == PTHREAD_PROCESS_SHARED)) {
+        *pshared = *attr;
+        return 0;
+    }
+    return EINVAL;
+}
+
+int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *attr, int pshared)
+{
+    if (attr && (pshared == PTHREAD_PROCESS_PRIVATE ||
+                 pshared == PTHREAD_PROCESS_SHARED)) {
+        *attr = pshared;
+        return 0;
+    }
+    return EINVAL;
+}
+
+int pthread_rwlock_init(pthread_rwlock_t *rwlock,
+                        const pthread_rwlockattr_t *attr)
+{
+    if (__unlikely(rwlock == NULL))
+        return EINVAL;
+
+    /* our futexes are never process-private, so 'attr' doesn't change
+     * anything here beyond validation.
+     */
+    if (attr != NULL && *attr != PTHREAD_PROCESS_PRIVATE &&
+                        *attr != PTHREAD_PROCESS_SHARED)
+        return EINVAL;
+
+    rwlock->state = 0;
+    rwlock->writer_tid = 0;
+    rwlock->pending_readers = 0;
+    rwlock->pending_writers = 0;
+    rwlock->reader_wakeup = 0;
+    rwlock->writer_wakeup = 0;
+    return 0;
+}
+
+int pthread_rwlock_destroy(pthread_rwlock_t *rwlock)
+{
+    if (__unlikely(rwlock == NULL))
+        return EINVAL;
+
+    if (rwlock->state != 0 || rwlock->pending_readers != 0 ||
+        rwlock->pending_writers != 0)
+        return EBUSY;
+
+    return 0;
+}
+
+static void _rwlock_wake_waiters(pthread_rwlock_t *rwlock)
+{
+    if (rwlock->pending_writers > 0) {
+        __atomic_inc(&rwlock->writer_wakeup);
+        __futex_wake(&rwlock->writer_wakeup, INT_MAX);
+    } else if (rwlock->pending_readers > 0) {
+        __atomic_inc(&rwlock->reader_wakeup);
+        __futex_wake(&rwlock->reader_wakeup, INT_MAX);
+    }
+}
+
+static int _rwlock_rdlock(pthread_rwlock_t *rwlock,
+                          const struct timespec *abstime)
+{
+    struct timespec ts;
+    struct timespec * tsp = NULL;
+
+    if (__unlikely(rwlock == NULL))
+        return EINVAL;
+
+    for (;;) {
+        int state = rwlock->state;
+        int wakeup;
+        int status = 0;
+
+        if (state >= 0 && rwlock->pending_writers == 0) {
+            if (__unlikely(state == INT_MAX))
+                return EAGAIN;
+            if (__atomic_cmpxchg(state, state + 1, &rwlock->state) == 0)
+                return 0;
+            continue;
+        }
+
+        if (state < 0 && rwlock->writer_tid == __get_thread()->kernel_id)
+            return EDEADLK;
+
+        if (abstime != NULL) {
+            if (__abstime_to_reltime(abstime, &ts) != 0)
+                return ETIMEDOUT;
+            tsp = &ts;
+        }
+
+        wakeup = rwlock->reader_wakeup;
+        __atomic_inc(&rwlock->pending_readers);
+        if (rwlock->state < 0 || rwlock->pending_writers > 0)
+            status = __futex_wait(&rwlock->reader_wakeup, wakeup, tsp);
+        __atomic_dec(&rwlock->pending_readers);
+
+        if (status == (-ETIMEDOUT))
+            return ETIMEDOUT;
+    }
+}
+
+static int _rwlock_wrlock(pthread_rwlock_t *rwlock,
+                          const struct timespec *abstime)
+{
+    struct timespec ts;
+    struct timespec * tsp = NULL;
+    int tid;
+
+    if (__unlikely(rwlock == NULL))
+        return EINVAL;
+
+    tid = __get_thread()->kernel_id;
+
+    for (;;) {
+        int state = rwlock->state;
+        int wakeup;
+        int status = 0;
+
+        if (state == 0) {
+            if (__atomic_cmpxchg(0, -1, &rwlock->state) == 0) {
+                rwlock->writer_tid = tid;
+                return 0;
+            }
+            continue;
+        }
+
+        if (state < 0 && rwlock->writer_tid == tid)
+            return EDEADLK;
+
+        if (abstime != NULL) {
+            if (__abstime_to_reltime(abstime, &ts) != 0)
+                return ETIMEDOUT;
+            tsp = &ts;
+        }
+
+        wakeup = rwlock->writer_wakeup;
+        __atomic_inc(&rwlock->pending_writers);
+        if (rwlock->state != 0)
+            status = __futex_wait(&rwlock->writer_wakeup, wakeup, tsp);
+
+        /* readers may be blocked only because we were pending. if we give
+         * up and were the last pending writer, nobody else would wake them.
+         */
+        if (__atomic_dec(&rwlock->pending_writers) == 1 &&
+            status == (-ETIMEDOUT)) {
+            if (rwlock->pending_readers > 0) {
+                __atomic_inc(&rwlock->reader_wakeup);
+                __futex_wake(&rwlock->reader_wakeup, INT_MAX);
+            }
+        }
+
+        if (status == (-ETIMEDOUT))
+            return ETIMEDOUT;
+    }
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+{
+    return _rwlock_rdlock(rwlock, NULL);
+}
+
+int pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock,
+                               const struct timespec *abstime)
+{
+    return _rwlock_rdlock(rwlock, abstime);
+}
+
+int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+{
+    int state;
+
+    if (__unlikely(rwlock == NULL))
+        return EINVAL;
+
+    do {
+        state = rwlock->state;
+        if (state < 0 || rwlock->pending_writers > 0)
+            return EBUSY;
+        if (__unlikely(state == INT_MAX))
+            return EAGAIN;
+    } while (__atomic_cmpxchg(state, state + 1, &rwlock->state) != 0);
+
+    return 0;
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
+{
+    return _rwlock_wrlock(rwlock, NULL);
+}
+
+int pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock,
+                               const struct timespec *abstime)
+{
+    return _rwlock_wrlock(rwlock, abstime);
+}
+
+int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
+{
+    if (__unlikely(rwlock == NULL))
+        return EINVAL;
+
+    if (__atomic_cmpxchg(0, -1, &rwlock->state) != 0)
+        return EBUSY;
+
+    rwlock->writer_tid = __get_thread()->kernel_id;
+    return 0;
+}
+
+int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
+{
+    int state;
+
+    if (__unlikely(rwlock == NULL))
+        return EINVAL;
+
+    state = rwlock->state;
+    if (state < 0) {
+        if (rwlock->writer_tid != __get_thread()->kernel_id)
+            return EPERM;
+        rwlock->writer_tid = 0;
+        __atomic_swap(0, &rwlock->state);
+        _rwlock_wake_waiters(rwlock);
+    } else if (state > 0) {
+        /* only the last reader out can let a waiter in */
+        if (__atomic_dec(&rwlock->state) == 1)
+            _rwlock_wake_waiters(rwlock);
+    } else {
+        return EPERM;
+    }
+    return 0;
+}
+
+
+/* spinlocks are a plain 0/1 word. a contended locker spins on reads only,
+ * so it doesn't keep bouncing the cache line with atomic operations, and
+ * yields the cpu from time to time in case the owner was preempted.
+ */
+#define  SPINLOCK_YIELD_COUNT  1000
+
+int pthread_spin_init(pthread_spinlock_t *lock, int pshared)
+{
+    if (__unlikely(lock == NULL))
+        return EINVAL;
+
+    if (pshared != PTHREAD_PROCESS_PRIVATE && pshared != PTHREAD_PROCESS_SHARED)
+        return EINVAL;
+
+    *lock = 0;
+    return 0;
+}
+
+int pthread_spin_destroy(pthread_spinlock_t *lock)
+{
+    if (__unlikely(lock == NULL))
+        return EINVAL;
+
+    if (*lock != 0)
+        return EBUSY;
+
+    return 0;
+}
+
+int pthread_spin_lock(pthread_spinlock_t *lock)
+{
+    if (__unlikely(lock == NULL))
+        return EINVAL;
+
+    while (__atomic_cmpxchg(0, 1, lock) != 0) {
+        int spins = 0;
+        while (*lock != 0) {
+            if (++spins == SPINLOCK_YIELD_COUNT) {
+                sched_yield();
+                spins = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+int pthread_spin_trylock(pthread_spinlock_t *lock)
+{
+    if (__unlikely(lock == NULL))
+        return EINVAL;
+
+    if (__atomic_cmpxchg(0, 1, lock) != 0)
+        return EBUSY;
+
+    return 0;
+}
+
+int pthread_spin_unlock(pthread_spinlock_t *lock)
+{
+    if (__unlikely(lock == NULL))
+        return EINVAL;
+
+    __atomic_swap(0, lock);
+    return 0;
+}
+
+
+/* a barrier counts arrivals in 'count'. the last thread to arrive resets
+ * it and bumps 'round', which the other threads wait on. since 'count'
+ * is reset before 'round' changes, threads released from one round can
+ * immediately re-enter the barrier for the next one.
+ */
+int pthread_barrierattr_init(pthread_barrierattr_t *attr)
+{
+    if (attr) {
+        *attr = PTHREAD_PROCESS_PRIVATE;
+        return 0;
+    } else {
+        return EINVAL;
+    }
+}
+
+int pthread_barrierattr_destroy(pthread_barrierattr_t *attr)
+{
+    if (attr) {
+        *attr = -1;
+        return 0;
+    } else {
+        return EINVAL;
+    }
+}
+
+int pthread_barrierattr_getpshared(const pthread_barrierattr_t *attr, int *pshared)
+{
+    if (attr && (*attr == PTHREAD_PROCESS_PRIVATE ||
+                 *attr == PTHREAD_PROCESS_SHARED)) {
+        *pshared = *attr;
+        return 0;
+    }
+    return EINVAL;
+}
+
+int pthread_barrierattr_setpshared(pthread_barrierattr_t *attr, int pshared)
+{
+    if (attr && (pshared == PTHREAD_PROCESS_PRIVATE ||
+                 pshared == PTHREAD_PROCESS_SHARED)) {
+        *attr = pshared;
+        return 0;
+    }
+    return EINVAL;
+}
+
+int pthread_barrier_init(pthread_barrier_t *barrier,
+                         const pthread_barrierattr_t *attr, unsigned count)
+{
+    if (__unlikely(barrier == NULL || count == 0 || count > INT_MAX))
+        return EINVAL;
+
+    if (attr != NULL && *attr != PTHREAD_PROCESS_PRIVATE &&
+                        *attr != PTHREAD_PROCESS_SHARED)
+        return EINVAL;
+
+    barrier->count = 0;
+    barrier->round = 0;
+    barrier->threshold = count;
+    return 0;
+}
+
+int pthread_barrier_destroy(pthread_barrier_t *barrier)
+{
+    if (__unlikely(barrier == NULL))
+        return EINVAL;
+
+    if (barrier->count != 0)
+        return EBUSY;
+
+    barrier->threshold = 0;
+    return 0;
+}
+
+int pthread_barrier_wait(pthread_barrier_t *barrier)
+{
+    int round;
+
+    if (__unlikely(barrier == NULL || barrier->threshold == 0))
+        return EINVAL;
+
+    /* must be sampled before we arrive: the round can't complete
+     * without us, so this is the round we're taking part in.
+     */
+    round = barrier->round;
+
+    if ((unsigned)(__atomic_inc(&barrier->count) + 1) == barrier->threshold) {
+        barrier->count = 0;
+        __atomic_inc(&barrier->round);
+        __futex_wake(&barrier->round, INT_MAX);
+        return PTHREAD_BARRIER_SERIAL_THREAD;
+    }
 
-    if(status == (-ETIMEDOUT)) return ETIMEDOUT;
+    while (barrier->round == round)
+        __futex_wait(&barrier->round, round, NULL);
 
     return 0;
 }
@@ -29,9 +29,12 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stddef.h>
+#include <limits.h>
+#include <string.h>
 #include <errno.h>
 
 #include <sys/mman.h>
+#include <time.h>
 
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -78,7 +81,9 @@ int __system_properties_init(void)
         return -1;
     }
 
-    if((pa->magic != PROP_AREA_MAGIC) || (pa->version != PROP_AREA_VERSION)) {
+    if((pa->magic != PROP_AREA_MAGIC) ||
+       ((pa->version != PROP_AREA_VERSION) &&
+        (pa->version != PROP_AREA_VERSION_INDEXED))) {
         munmap(pa, sz);
         return -1;
     }
@@ -98,6 +103,40 @@ const prop_info *__system_property_find_nth(unsigned n)
     }
 }
 
+static unsigned prop_name_hash(const char *name, unsigned len)
+{
+    const unsigned char *p = (const unsigned char *) name;
+    unsigned h = 2166136261U;
+
+    while(len--) {
+        h ^= *p++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static const prop_info *find_indexed(prop_area *pa, const char *name,
+                                     unsigned len)
+{
+    unsigned hash = prop_name_hash(name, len);
+    struct prop_index_entry *entry = PROP_INDEX_ENTRY(pa);
+    unsigned n = PROP_INDEX_BUCKET(pa)[hash % PROP_INDEX_NBUCKET(pa)];
+    prop_info *pi;
+
+    for(; n != 0; n = entry[n - 1].next) {
+        unsigned toc = pa->toc[n - 1];
+        if(entry[n - 1].hash != hash) continue;
+        if(TOC_NAME_LEN(toc) != len) continue;
+
+        pi = TOC_TO_INFO(pa, toc);
+        if(memcmp(name, pi->name, len)) continue;
+
+        return pi;
+    }
+
+    return 0;
+}
+
 const prop_info *__system_property_find(const char *name)
 {
     prop_area *pa = __system_property_area__;
@@ -106,6 +145,13 @@ const prop_info *__system_property_find(const char *name)
     unsigned len = strlen(name);
     prop_info *pi;
 
+    if(count == 0) {
+        return 0;
+    }
+    if(pa->version == PROP_AREA_VERSION_INDEXED) {
+        return find_indexed(pa, name, len);
+    }
+
     while(count--) {
         unsigned entry = *toc++;
         if(TOC_NAME_LEN(entry) != len) continue;
@@ -119,27 +165,65 @@ const prop_info *__system_property_find(const char *name)
     return 0;
 }
 
-int __system_property_read(const prop_info *pi, char *name, char *value)
+static unsigned wait_clean_serial(const prop_info *pi)
 {
-    unsigned serial, len;
-    
-    for(;;) {
+    unsigned serial = pi->serial;
+
+    while(SERIAL_DIRTY(serial)) {
+        __futex_wait((volatile void *)&pi->serial, serial, 0);
         serial = pi->serial;
-        while(SERIAL_DIRTY(serial)) {
-            __futex_wait(&pi->serial, serial, 0);
-            serial = pi->serial;
-        }
-        len = SERIAL_VALUE_LEN(serial);
-        memcpy(value, pi->value, len + 1);
+    }
+    return serial;
+}
+
+/* Copy a consistent value of pi, and return the serial it was read at. */
+static unsigned read_value(const prop_info *pi, char *value)
+{
+    unsigned serial;
+
+    for(;;) {
+        serial = wait_clean_serial(pi);
+        memcpy(value, pi->value, SERIAL_VALUE_LEN(serial) + 1);
         if(serial == pi->serial) {
-            if(name != 0) {
-                strcpy(name, pi->name);
-            }
-            return len;
+            return serial;
         }
     }
 }
 
+int __system_property_read(const prop_info *pi, char *name, char *value)
+{
+    unsigned serial = read_value(pi, value);
+
+    if(name != 0) {
+        strcpy(name, pi->name);
+    }
+    return SERIAL_VALUE_LEN(serial);
+}
+
+unsigned __system_property_serial(const prop_info *pi)
+{
+    return wait_clean_serial(pi);
+}
+
+int __system_property_read_if_changed(const prop_info *pi, unsigned *serial,
+                                      char *value)
+{
+    unsigned current;
+
+    /* the common case: a single load, no copy */
+    if(pi->serial == *serial) {
+        return -1;
+    }
+
+    current = read_value(pi, value);
+    if(current == *serial) {
+        /* it was only being rewritten with the same serial... */
+        return -1;
+    }
+    *serial = current;
+    return SERIAL_VALUE_LEN(current);
+}
+
 int __system_property_get(const char *name, char *value)
 {
     const prop_info *pi = __system_property_find(name);
@@ -169,3 +253,172 @@ int __system_property_wait(const prop_info *pi)
     }
     return 0;
 }
+
+/* Lay out an empty indexed property area in the size bytes at data, and
+** make it the current area.  The toc, the index and the prop_info
+** entries are sized so that they all fit.
+*/
+int __system_property_area_init(void *data, unsigned size)
+{
+    prop_area *pa = data;
+    unsigned header = offsetof(prop_area, toc) +
+                      PROP_INDEX_BUCKETS * sizeof(unsigned);
+    unsigned per_entry = sizeof(unsigned) + sizeof(struct prop_index_entry) +
+                         sizeof(prop_info);
+    unsigned capacity;
+
+    if(size < header + per_entry) {
+        return -1;
+    }
+    capacity = (size - header) / per_entry;
+
+    memset(pa, 0, size);
+    pa->magic = PROP_AREA_MAGIC;
+    pa->version = PROP_AREA_VERSION_INDEXED;
+    PROP_INDEX_OFFSET(pa) = offsetof(prop_area, toc) +
+                            capacity * sizeof(unsigned);
+    PROP_INDEX_NBUCKET(pa) = PROP_INDEX_BUCKETS;
+    PROP_INDEX_CAPACITY(pa) = capacity;
+    PROP_INDEX_NEXT_FREE(pa) = (unsigned) ((char*) (PROP_INDEX_ENTRY(pa) +
+                                                    capacity) - (char*) pa);
+
+    __system_property_area__ = pa;
+    return 0;
+}
+
+/* Add a new property to an area set up by __system_property_area_init().
+** The caller must make sure that there is no property with this name yet.
+*/
+int __system_property_add(const char *name, unsigned namelen,
+                          const char *value, unsigned valuelen)
+{
+    prop_area *pa = __system_property_area__;
+    unsigned n = pa->count;
+    unsigned hash, slot, offset;
+    struct prop_index_entry *entry;
+    prop_info *pi;
+
+    if((pa->version != PROP_AREA_VERSION_INDEXED) ||
+       (n >= PROP_INDEX_CAPACITY(pa)) ||
+       (namelen >= PROP_NAME_MAX) || (valuelen >= PROP_VALUE_MAX)) {
+        return -1;
+    }
+
+    offset = PROP_INDEX_NEXT_FREE(pa);
+    pi = (prop_info*) (((char*) pa) + offset);
+    memcpy(pi->name, name, namelen);
+    pi->name[namelen] = 0;
+    memcpy(pi->value, value, valuelen);
+    pi->value[valuelen] = 0;
+    pi->serial = valuelen << 24;
+    PROP_INDEX_NEXT_FREE(pa) = offset + sizeof(prop_info);
+    pa->toc[n] = (namelen << 24) | offset;
+
+    hash = prop_name_hash(name, namelen);
+    slot = hash % PROP_INDEX_NBUCKET(pa);
+    entry = PROP_INDEX_ENTRY(pa);
+    entry[n].hash = hash;
+    entry[n].next = PROP_INDEX_BUCKET(pa)[slot];
+
+    /* publish: readers may find the entry through the bucket before
+    ** count is bumped, so it must be complete by now.
+    */
+    __atomic_swap(n + 1, (volatile int*) &PROP_INDEX_BUCKET(pa)[slot]);
+    __atomic_swap(n + 1, (volatile int*) &pa->count);
+
+    __atomic_inc((volatile int*) &pa->serial);
+    __futex_wake(&pa->serial, INT_MAX);
+    return 0;
+}
+
+/* Change the value of an existing property, following the serial
+** protocol described in <sys/_system_properties.h>.
+*/
+int __system_property_update(prop_info *pi, const char *value,
+                             unsigned len)
+{
+    prop_area *pa = __system_property_area__;
+
+    if(len >= PROP_VALUE_MAX) {
+        return -1;
+    }
+
+    __atomic_swap(pi->serial | 1, (volatile int*) &pi->serial);
+    memcpy(pi->value, value, len + 1);
+    __atomic_swap((len << 24) | ((pi->serial + 1) & 0xffffff),
+                  (volatile int*) &pi->serial);
+    __futex_wake(&pi->serial, INT_MAX);
+
+    __atomic_inc((volatile int*) &pa->serial);
+    __futex_wake(&pa->serial, INT_MAX);
+    return 0;
+}
+
+/* Writers that predate the area serial (such as an older init) only
+** bump and wake the serial of the property itself. A single property is
+** waited on directly; for several, the area serial is only a hint and the
+** properties are polled again at least this often.
+*/
+#define PROP_WAIT_POLL_MS   200
+
+int __system_property_wait_any(const prop_info * const *pis,
+                               const unsigned *serials, unsigned count,
+                               unsigned msecs)
+{
+    prop_area *pa = __system_property_area__;
+    struct timespec now, deadline, ts;
+    volatile unsigned *futex;
+    unsigned expected, n;
+
+    if(msecs != 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += msecs / 1000;
+        deadline.tv_nsec += (msecs % 1000) * 1000000;
+        if(deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    for(;;) {
+        /* Sample the word we sleep on before the checks below, so a
+        ** change between them and the futex wait can't be missed.
+        */
+        futex = (count == 1) ? &pis[0]->serial : &pa->serial;
+        expected = *futex;
+        for(n = 0; n < count; n++) {
+            if(pis[n]->serial != serials[n]) {
+                return n;
+            }
+        }
+
+        if(count == 1) {
+            ts.tv_sec = INT_MAX;    /* only bounded by the deadline */
+            ts.tv_nsec = 0;
+        } else {
+            ts.tv_sec = PROP_WAIT_POLL_MS / 1000;
+            ts.tv_nsec = (PROP_WAIT_POLL_MS % 1000) * 1000000;
+        }
+
+        if(msecs != 0) {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            now.tv_sec = deadline.tv_sec - now.tv_sec;
+            now.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if(now.tv_nsec < 0) {
+                now.tv_sec--;
+                now.tv_nsec += 1000000000;
+            }
+            if(now.tv_sec < 0 || (now.tv_sec == 0 && now.tv_nsec == 0)) {
+                return -1;
+            }
+            if(now.tv_sec < ts.tv_sec ||
+               (now.tv_sec == ts.tv_sec && now.tv_nsec < ts.tv_nsec)) {
+                ts = now;
+            }
+        }
+
+        /* timeouts are handled by the deadline check above */
+        __futex_wait((volatile void *)futex, expected,
+                     (count == 1 && msecs == 0) ? NULL : &ts);
+    }
+}
@@ -42,6 +42,15 @@ extern void*   memalign(size_t  alignment, size_t  bytesize);
 extern void*   valloc(size_t  bytesize);
 extern void*   pvalloc(size_t  bytesize);
 extern int     mallopt(int  param_number, int  param_value);
+
+/* mallopt() parameters */
+#define M_TRIM_THRESHOLD     (-1)
+#define M_GRANULARITY        (-2)
+#define M_MMAP_THRESHOLD     (-3)
+#define M_TCACHE_COUNT       (-4)   /* chunks kept per size class and thread */
+#define M_TCACHE_MAX         (-5)   /* largest request served by thread caches */
+#define M_ARENAS             (-6)   /* number of heaps threads are spread over */
+
 extern size_t  malloc_footprint(void);
 extern size_t  malloc_max_footprint(void);
 
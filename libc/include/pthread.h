@@ -45,11 +45,13 @@ typedef struct
 #define  PTHREAD_MUTEX_INITIALIZER             {0}
 #define  PTHREAD_RECURSIVE_MUTEX_INITIALIZER   {0x4000}
 #define  PTHREAD_ERRORCHECK_MUTEX_INITIALIZER  {0x8000}
+#define  PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP {0xc000}
 
 enum {
     PTHREAD_MUTEX_NORMAL = 0,
     PTHREAD_MUTEX_RECURSIVE = 1,
     PTHREAD_MUTEX_ERRORCHECK = 2,
+    PTHREAD_MUTEX_ADAPTIVE_NP = 3,
 
     PTHREAD_MUTEX_ERRORCHECK_NP = PTHREAD_MUTEX_ERRORCHECK,
     PTHREAD_MUTEX_RECURSIVE_NP  = PTHREAD_MUTEX_RECURSIVE,
@@ -82,6 +84,34 @@ typedef long pthread_t;
 
 typedef volatile int  pthread_once_t;
 
+/* a rwlock is write-locked when 'state' is -1, read-locked by 'state'
+ * readers when it is positive. 'reader_wakeup' and 'writer_wakeup' are
+ * the futex words waiters sleep on; they are bumped on each release that
+ * may let a waiter of that kind proceed.
+ */
+typedef struct
+{
+    int volatile state;
+    int volatile writer_tid;
+    int volatile pending_readers;
+    int volatile pending_writers;
+    int volatile reader_wakeup;
+    int volatile writer_wakeup;
+} pthread_rwlock_t;
+
+typedef long pthread_rwlockattr_t;
+
+typedef volatile int  pthread_spinlock_t;
+
+typedef struct
+{
+    int volatile count;
+    int volatile round;
+    unsigned     threshold;
+} pthread_barrier_t;
+
+typedef long pthread_barrierattr_t;
+
 /*
  * Defines
  */
@@ -94,6 +124,10 @@ typedef volatile int  pthread_once_t;
 
 #define PTHREAD_ONCE_INIT    0
 
+#define PTHREAD_RWLOCK_INITIALIZER  {0, 0, 0, 0, 0, 0}
+
+#define PTHREAD_BARRIER_SERIAL_THREAD  (-1)
+
 #define PTHREAD_PROCESS_PRIVATE  0
 #define PTHREAD_PROCESS_SHARED   1
 
@@ -157,6 +191,33 @@ int pthread_mutex_unlock(pthread_mutex_t *mutex);
 int pthread_mutex_trylock(pthread_mutex_t *mutex);
 int pthread_mutex_timedlock(pthread_mutex_t *mutex, struct timespec*  ts);
 
+/* BIONIC: adaptive mutexes (PTHREAD_MUTEX_ADAPTIVE_NP) spin for a bounded
+ *         number of iterations on a contended lock before going to sleep
+ *         in the kernel. they behave like normal mutexes otherwise.
+ *
+ *         pthread_mutex_setspin_np() sets the spin count used by adaptive
+ *         mutexes and returns the previous one (a negative value restores
+ *         the default, which is 0 on uniprocessor systems).
+ *
+ *         pthread_mutex_setdefaulttype_np() selects the type used by
+ *         pthread_mutex_init() with a NULL attribute and by
+ *         pthread_mutexattr_init(), either PTHREAD_MUTEX_NORMAL or
+ *         PTHREAD_MUTEX_ADAPTIVE_NP. static initializers are not affected.
+ *
+ *         pthread_mutex_getstats_np() returns process-wide contention
+ *         counters for adaptive mutexes, and resets them if 'reset' is
+ *         non-zero.
+ */
+struct pthread_mutex_stats_np {
+    unsigned  contended;    /* lock attempts that found the mutex held */
+    unsigned  spin_hits;    /* ... and acquired it while spinning */
+    unsigned  sleeps;       /* futex waits */
+};
+
+int pthread_mutex_setspin_np(int spins);
+int pthread_mutex_setdefaulttype_np(int type);
+void pthread_mutex_getstats_np(struct pthread_mutex_stats_np *stats, int reset);
+
 int pthread_cond_init(pthread_cond_t *cond,
                       const pthread_condattr_t *attr);
 int pthread_cond_destroy(pthread_cond_t *cond);
@@ -179,6 +240,45 @@ int pthread_cond_timeout_np(pthread_cond_t *cond,
                             pthread_mutex_t * mutex,
                             unsigned msecs);
 
+int pthread_rwlockattr_init(pthread_rwlockattr_t *attr);
+int pthread_rwlockattr_destroy(pthread_rwlockattr_t *attr);
+int pthread_rwlockattr_getpshared(const pthread_rwlockattr_t *attr, int *pshared);
+int pthread_rwlockattr_setpshared(pthread_rwlockattr_t *attr, int pshared);
+
+/* BIONIC: rwlocks prefer writers: once a writer is waiting, new readers
+ *         block until it has acquired and released the lock. This means
+ *         a thread that already holds a read lock must not try to take
+ *         it again for reading, or it may deadlock against a writer.
+ */
+int pthread_rwlock_init(pthread_rwlock_t *rwlock,
+                        const pthread_rwlockattr_t *attr);
+int pthread_rwlock_destroy(pthread_rwlock_t *rwlock);
+int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock);
+int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock);
+int pthread_rwlock_timedrdlock(pthread_rwlock_t *rwlock,
+                               const struct timespec *abstime);
+int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock);
+int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock);
+int pthread_rwlock_timedwrlock(pthread_rwlock_t *rwlock,
+                               const struct timespec *abstime);
+int pthread_rwlock_unlock(pthread_rwlock_t *rwlock);
+
+int pthread_spin_init(pthread_spinlock_t *lock, int pshared);
+int pthread_spin_destroy(pthread_spinlock_t *lock);
+int pthread_spin_lock(pthread_spinlock_t *lock);
+int pthread_spin_trylock(pthread_spinlock_t *lock);
+int pthread_spin_unlock(pthread_spinlock_t *lock);
+
+int pthread_barrierattr_init(pthread_barrierattr_t *attr);
+int pthread_barrierattr_destroy(pthread_barrierattr_t *attr);
+int pthread_barrierattr_getpshared(const pthread_barrierattr_t *attr, int *pshared);
+int pthread_barrierattr_setpshared(pthread_barrierattr_t *attr, int pshared);
+
+int pthread_barrier_init(pthread_barrier_t *barrier,
+                         const pthread_barrierattr_t *attr, unsigned count);
+int pthread_barrier_destroy(pthread_barrier_t *barrier);
+int pthread_barrier_wait(pthread_barrier_t *barrier);
+
 int pthread_key_create(pthread_key_t *key, void (*destructor_function)(void *));
 int pthread_key_delete (pthread_key_t);
 int pthread_setspecific(pthread_key_t key, const void *value);
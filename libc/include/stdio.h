@@ -297,7 +297,7 @@ int	 pclose(FILE *);
 FILE	*popen(const char *, const char *);
 #endif
 
-#if __POSIX_VISIBLE >= 199506
+/* BIONIC: always declared, there are no macro versions to fall back on */
 void	 flockfile(FILE *);
 int	 ftrylockfile(FILE *);
 void	 funlockfile(FILE *);
@@ -310,19 +310,12 @@ int	 getc_unlocked(FILE *);
 int	 getchar_unlocked(void);
 int	 putc_unlocked(int, FILE *);
 int	 putchar_unlocked(int);
-#endif /* __POSIX_VISIBLE >= 199506 */
 
 #if __XPG_VISIBLE
 char	*tempnam(const char *, const char *);
 #endif
 __END_DECLS
 
-#ifndef _POSIX_THREADS
-#  define flockfile(fp)			/* nothing */
-#  define ftrylockfile(fp)		(0)
-#  define funlockfile(fp)		/* nothing */
-#endif
-
 #endif /* __BSD_VISIBLE || __POSIX_VISIBLE || __XPG_VISIBLE */
 
 /*
@@ -342,6 +335,22 @@ int	 setlinebuf(FILE *);
 int	 vasprintf(char **, const char *, __va_list)
 		__attribute__((__format__ (printf, 2, 0)))
 		__attribute__((__nonnull__ (2)));
+
+/*
+ * Versions of the stdio functions that don't take the FILE lock, for
+ * callers that already hold it through flockfile().
+ */
+void	 clearerr_unlocked(FILE *);
+int	 feof_unlocked(FILE *);
+int	 ferror_unlocked(FILE *);
+int	 fileno_unlocked(FILE *);
+int	 fflush_unlocked(FILE *);
+int	 fgetc_unlocked(FILE *);
+int	 fputc_unlocked(int, FILE *);
+char	*fgets_unlocked(char *, int, FILE *);
+int	 fputs_unlocked(const char *, FILE *);
+size_t	 fread_unlocked(void *, size_t, size_t, FILE *);
+size_t	 fwrite_unlocked(const void *, size_t, size_t, FILE *);
 __END_DECLS
 
 /*
@@ -397,30 +406,31 @@ static __inline int __sputc(int _c, FILE *_p) {
 #define	__sclearerr(p)	((void)((p)->_flags &= ~(__SERR|__SEOF)))
 #define	__sfileno(p)	((p)->_file)
 
+/*
+ * BIONIC: getc(), putc() and clearerr() take the FILE lock, so they are
+ * functions; only their *_unlocked versions are macros.
+ */
 #define	feof(p)		__sfeof(p)
 #define	ferror(p)	__sferror(p)
 
-#ifndef _POSIX_THREADS
-#define	clearerr(p)	__sclearerr(p)
-#endif
-
 #if __POSIX_VISIBLE
 #define	fileno(p)	__sfileno(p)
 #endif
 
+#if __BSD_VISIBLE
+#define	feof_unlocked(p)	__sfeof(p)
+#define	ferror_unlocked(p)	__sferror(p)
+#define	clearerr_unlocked(p)	__sclearerr(p)
+#define	fileno_unlocked(p)	__sfileno(p)
+#endif
+
 #ifndef lint
-#ifndef _POSIX_THREADS
-#define	getc(fp)	__sgetc(fp)
-#endif /* _POSIX_THREADS */
 #define	getc_unlocked(fp)	__sgetc(fp)
 /*
- * The macro implementations of putc and putc_unlocked are not
- * fully POSIX compliant; they do not set errno on failure
+ * The macro implementation of putc_unlocked is not
+ * fully POSIX compliant; it does not set errno on failure
  */
 #if __BSD_VISIBLE
-#ifndef _POSIX_THREADS
-#define putc(x, fp)	__sputc(x, fp)
-#endif /* _POSIX_THREADS */
 #define putc_unlocked(x, fp)	__sputc(x, fp)
 #endif /* __BSD_VISIBLE */
 #endif /* lint */
@@ -40,6 +40,11 @@ typedef struct prop_msg prop_msg;
 #define PROP_AREA_MAGIC   0x504f5250
 #define PROP_AREA_VERSION 0x45434f76
 
+/* Same layout as PROP_AREA_VERSION, plus a hash index over the property
+** names (see "Indexed areas" below).
+*/
+#define PROP_AREA_VERSION_INDEXED 0x45434f77
+
 #define PROP_SERVICE_NAME "property_service"
 
 /* #define PROP_MAX_ENTRIES 247 */
@@ -60,6 +65,25 @@ struct prop_area {
 #define SERIAL_VALUE_LEN(serial) ((serial) >> 24)
 #define SERIAL_DIRTY(serial) ((serial) & 1)
 
+/* Indexed areas: prop_area.reserved[] describes the index */
+#define PROP_INDEX_OFFSET(area)    ((area)->reserved[0])
+#define PROP_INDEX_NBUCKET(area)   ((area)->reserved[1])
+#define PROP_INDEX_CAPACITY(area)  ((area)->reserved[2])
+#define PROP_INDEX_NEXT_FREE(area) ((area)->reserved[3])
+
+#define PROP_INDEX_BUCKETS 128
+
+struct prop_index_entry {
+    unsigned hash;
+    unsigned next;
+};
+
+#define PROP_INDEX_BUCKET(area) \
+    ((unsigned volatile *) (((char*) (area)) + PROP_INDEX_OFFSET(area)))
+#define PROP_INDEX_ENTRY(area) \
+    ((struct prop_index_entry *) \
+     (PROP_INDEX_BUCKET(area) + PROP_INDEX_NBUCKET(area)))
+
 struct prop_info {
     unsigned char name[PROP_NAME_MAX];
     unsigned volatile serial;
@@ -93,12 +117,29 @@ struct prop_msg
 **   2. memcpy(pi->value, local_value, value_len)
 **   3. pi->serial = (value_len << 24) | ((pi->serial + 1) & 0xffffff)
 **
-** Improvements:
-** - maintain the toc sorted by pi->name to allow lookup
-**   by binary search
+** Indexed areas (PROP_AREA_VERSION_INDEXED):
+** - the area also holds PROP_INDEX_NBUCKET bucket words followed by
+**   PROP_INDEX_CAPACITY prop_index_entry, starting PROP_INDEX_OFFSET
+**   bytes into the area.  Buckets and next links hold a toc index + 1,
+**   0 ends a chain.  hash is the 32-bit FNV-1a hash of the name.
+** - adding the property at toc index n requires the following steps
+**   1. fill in the prop_info and toc[n]
+**   2. entry[n].hash = hash, entry[n].next = bucket[hash % nbucket]
+**   3. bucket[hash % nbucket] = n + 1
+**   4. count = n + 1
+** - so a lookup only needs to hash the name and walk one short chain.
+**   __system_property_area_init(), __system_property_add() and
+**   __system_property_update() implement the writer side.
 **
 */
 
+/* Writer-side helpers, for the property service only. */
+int __system_property_area_init(void *data, unsigned size);
+int __system_property_add(const char *name, unsigned namelen,
+                          const char *value, unsigned valuelen);
+int __system_property_update(prop_info *pi, const char *value,
+                             unsigned len);
+
 #define PROP_PATH_RAMDISK_DEFAULT  "/default.prop"
 #define PROP_PATH_SYSTEM_BUILD     "/system/build.prop"
 #define PROP_PATH_SYSTEM_DEFAULT   "/system/default.prop"
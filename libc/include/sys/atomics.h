@@ -37,8 +37,14 @@ extern int __atomic_swap(int _new, volatile int *ptr);
 extern int __atomic_dec(volatile int *ptr);
 extern int __atomic_inc(volatile int *ptr);
 
+/* full memory barrier: the functions above don't order the surrounding
+ * accesses on every CPU */
+extern void __memory_barrier(void);
+
 int __futex_wait(volatile void *ftx, int val, const struct timespec *timeout);
 int __futex_wake(volatile void *ftx, int count);
+int __futex_cmp_requeue(volatile void *ftx, int nwake, int nrequeue,
+                        volatile void *ftx2, int val);
 
 __END_DECLS
 
@@ -130,6 +130,7 @@
 #ifdef __arm__
 #define __NR_exit_group                   (__NR_SYSCALL_BASE + 248)
 #define __NR_waitid                       (__NR_SYSCALL_BASE + 280)
+#define __NR_set_tid_address              (__NR_SYSCALL_BASE + 256)
 #define __NR_openat                       (__NR_SYSCALL_BASE + 322)
 #define __NR_madvise                      (__NR_SYSCALL_BASE + 220)
 #define __NR_mincore                      (__NR_SYSCALL_BASE + 219)
@@ -192,6 +193,7 @@
 #define __NR_exit_group                   (__NR_SYSCALL_BASE + 252)
 #define __NR_waitpid                      (__NR_SYSCALL_BASE + 7)
 #define __NR_waitid                       (__NR_SYSCALL_BASE + 284)
+#define __NR_set_tid_address              (__NR_SYSCALL_BASE + 258)
 #define __NR_kill                         (__NR_SYSCALL_BASE + 37)
 #define __NR_tkill                        (__NR_SYSCALL_BASE + 238)
 #define __NR_set_thread_area              (__NR_SYSCALL_BASE + 243)
@@ -7,7 +7,7 @@ extern "C" {
 
 void             _exit (int);
 void             _exit_thread (int);
-int              fork (void);
+int              __fork (void);
 pid_t            _waitpid (pid_t, int*, int, struct rusage*);
 int              waitid (int, pid_t, struct siginfo_t*, int,void*);
 pid_t            __clone (int (*fn)(void*), void *child_stack, int flags, void *arg);
@@ -20,6 +20,7 @@ gid_t            getegid (void);
 uid_t            getresuid (void);
 gid_t            getresgid (void);
 pid_t            gettid (void);
+pid_t            __set_tid_address (int* tidptr);
 int              getgroups (int, gid_t *);
 pid_t            getpgid (pid_t);
 pid_t            getppid (void);
@@ -76,4 +76,35 @@ int __system_property_read(const prop_info *pi, char *name, char *value);
 */ 
 const prop_info *__system_property_find_nth(unsigned n);
 
+/* Return the serial of a system property.  The serial changes
+** every time the value does, so a caller can keep a prop_info
+** pointer (which stays valid, see __system_property_find())
+** together with the last serial it has seen, and use the calls
+** below to avoid copying values that did not change.
+*/
+unsigned __system_property_serial(const prop_info *pi);
+
+/* Read the value of a system property like __system_property_read(),
+** but only if its serial differs from *serial.  If the value was
+** copied, *serial is updated and the length of the value is
+** returned.  Otherwise -1 is returned, value is left untouched,
+** and the call costs a single memory load.
+*/
+int __system_property_read_if_changed(const prop_info *pi, unsigned *serial,
+                                      char *value);
+
+/* Wait until the serial of any of the count properties in pis
+** differs from the corresponding entry in serials.  Returns the
+** index of the first such property, or -1 if msecs milliseconds
+** elapsed first.  A msecs of 0 means wait forever.
+**
+** Writers must bump the property serial and futex-wake it.  Waits
+** on several properties are only prompt if writers also bump and
+** wake the area serial, as __system_property_update() does; with
+** other writers, changes are noticed within 200 milliseconds.
+*/
+int __system_property_wait_any(const prop_info * const *pis,
+                               const unsigned *serials, unsigned count,
+                               unsigned msecs);
+
 #endif
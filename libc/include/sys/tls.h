@@ -49,18 +49,24 @@ __BEGIN_DECLS
 #define TLS_SLOT_OPENGL_API         3
 #define TLS_SLOT_OPENGL             4
 
+/* per-thread malloc cache, see THREAD_CACHE in dlmalloc.c */
+#define TLS_SLOT_MALLOC             5
+
+/* bytes left until the next heap profile sample, see malloc_leak.c */
+#define TLS_SLOT_MALLOC_SAMPLE      6
+
 /* small technical note: it is not possible to call pthread_setspecific
  * on keys that are <= TLS_SLOT_MAX_WELL_KNOWN, which is why it is set to
  * TLS_SLOT_ERRNO.
  *
- * later slots like TLS_SLOT_OPENGL are pre-allocated through the use of
+ * later slots like TLS_SLOT_OPENGL and TLS_SLOT_MALLOC are pre-allocated through the use of
  * TLS_DEFAULT_ALLOC_MAP. this means that there is no need to use
  * pthread_key_create() to initialize them. on the other hand, there is
  * no destructor associated to them (we might need to implement this later)
  */
 #define TLS_SLOT_MAX_WELL_KNOWN     TLS_SLOT_ERRNO
 
-#define TLS_DEFAULT_ALLOC_MAP       0x0000001F
+#define TLS_DEFAULT_ALLOC_MAP       0x0000007F
 
 /* set the Thread Local Storage, must contain at least BIONIC_TLS_SLOTS pointers */
 extern void __init_tls(void**  tls, void*  thread_info);
@@ -1506,17 +1506,21 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
     res_state res)
 {
 	u_char buf[MAXPACKET];
+	u_char buf2[PACKETSZ];	/* res_nsend2() won't take more anyway */
 	HEADER *hp;
-	int n;
+	int n, n2;
 	struct res_target *t;
 	int rcode;
 	int ancount;
+	int sent;
 
 	assert(name != NULL);
 	/* XXX: target may be NULL??? */
 
 	rcode = NOERROR;
 	ancount = 0;
+	sent = 0;
+	n2 = -1;
 
 	for (t = target; t; t = t->next) {
 		int class, type;
@@ -1524,13 +1528,20 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 		int anslen;
 
 		hp = (HEADER *)(void *)t->answer;
-		hp->rcode = NOERROR;	/* default */
 
 		/* make it easier... */
 		class = t->qclass;
 		type = t->qtype;
 		answer = t->answer;
 		anslen = t->anslen;
+
+		if (sent) {
+			/* this question went out along with the previous one */
+			sent = 0;
+			n = n2;
+			goto answered;
+		}
+		hp->rcode = NOERROR;	/* default */
 #ifdef DEBUG
 		if (res->options & RES_DEBUG)
 			printf(";; res_nquery(%s, %d, %d)\n", name, class, type);
@@ -1550,7 +1561,36 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 			h_errno = NO_RECOVERY;
 			return n;
 		}
-		n = res_nsend(res, buf, n, answer, anslen);
+
+		/*
+		 * Typically A and AAAA for AF_UNSPEC: send the next question
+		 * together with this one, so that both answers come back in
+		 * a single round trip.  If it can't be built, it will simply
+		 * be sent on its own at the next iteration.
+		 */
+		if (t->next != NULL) {
+			n2 = res_nmkquery(res, QUERY, name, t->next->qclass,
+			    t->next->qtype, NULL, 0, NULL, buf2, sizeof(buf2));
+#ifdef RES_USE_EDNS0
+			if (n2 > 0 && (res->options & RES_USE_EDNS0) != 0)
+				n2 = res_nopt(res, n2, buf2, sizeof(buf2),
+				    t->next->anslen);
+#endif
+		} else
+			n2 = -1;
+		if (n2 > 0) {
+			HEADER *qhp = (HEADER *)(void *)buf;
+			HEADER *qhp2 = (HEADER *)(void *)buf2;
+
+			/* replies are matched to queries by ID */
+			if (qhp2->id == qhp->id)
+				qhp2->id = qhp->id + 1;
+			((HEADER *)(void *)t->next->answer)->rcode = NOERROR;
+			n = res_nsend2(res, buf, n, answer, anslen,
+			    buf2, n2, t->next->answer, t->next->anslen, &n2);
+			sent = 1;
+		} else
+			n = res_nsend(res, buf, n, answer, anslen);
 #if 0
 		if (n < 0) {
 #ifdef DEBUG
@@ -1562,6 +1602,7 @@ res_queryN(const char *name, /* domain name */ struct res_target *target,
 		}
 #endif
 
+answered:
 		if (n < 0 || hp->rcode != NOERROR || ntohs(hp->ancount) == 0) {
 			rcode = hp->rcode;	/* record most recent error */
 #ifdef DEBUG
@@ -46,22 +46,18 @@ endservent(void)
     /* nothing to do */
 }
 
-struct servent *
-getservent_r( res_static  rs )
+/* copy the _services record at 'p' to rs->servent, and return a pointer
+ * to the next record, or NULL on error
+ */
+static const char*
+_servent_fill( res_static  rs, const char*  p )
 {
-    const char*  p;
     const char*  q;
     int          namelen;
     int          nn,count;
     int          total = 0;
     char*        p2;
 
-    p = rs->servent_ptr;
-    if (p == NULL)
-        p = _services;
-    else if (p[0] == 0)
-        return NULL;
-
     /* first compute the total size */
     namelen = p[0];
     total  += namelen + 1;
@@ -76,13 +72,17 @@ getservent_r( res_static  rs )
         q     += 1 + len2;
     }
 
-    /* reallocate the thread-specific servent struct */
-    p2 = realloc( (char*)rs->servent.s_aliases, total );
-    if (p2 == NULL)
-        return NULL;
+    /* grow the thread-specific servent struct if needed */
+    if (total > rs->servent_size) {
+        p2 = realloc( (char*)rs->servent.s_aliases, total );
+        if (p2 == NULL)
+            return NULL;
+        rs->servent.s_aliases = (char**) p2;
+        rs->servent_size      = total;
+    }
 
     /* now write to it */
-    rs->servent.s_aliases = (char**) p2;
+    p2 = (char*) rs->servent.s_aliases;
     p2                   += (count+1)*sizeof(char*);
     rs->servent.s_name    = p2;
     p2                   += namelen + 1;
@@ -108,11 +108,118 @@ getservent_r( res_static  rs )
     }
     rs->servent.s_aliases[nn] = NULL;
 
+    return p;
+}
+
+struct servent *
+getservent_r( res_static  rs )
+{
+    const char*  p;
+
+    p = rs->servent_ptr;
+    if (p == NULL)
+        p = _services;
+    else if (p[0] == 0)
+        return NULL;
+
+    p = _servent_fill(rs, p);
+    if (p == NULL)
+        return NULL;
+
     rs->servent_ptr = p;
 
     return &rs->servent;
 }
 
+/* the hash functions must match the ones in libc/tools/genserv.py */
+static unsigned
+_servent_name_hash( const char*  name )
+{
+    unsigned  h = 2166136261U;
+
+    while (*name)
+        h = (h ^ (unsigned char)*name++) * 16777619U;
+
+    return h;
+}
+
+static unsigned
+_servent_port_hash( int  port )
+{
+    return ((unsigned)port * 2654435761U) >> 16;
+}
+
+static int
+_servent_proto_match( const char*  p, const char*  proto )
+{
+    /* 'p' points to the record's port, followed by its protocol */
+    if (proto == NULL)
+        return 1;
+
+    return !strcmp(proto, p[2] == 't' ? "tcp" : "udp");
+}
+
+/* look up a name or alias in the index generated with _services */
+struct servent *
+_servent_byname( res_static  rs, const char*  name, const char*  proto )
+{
+    unsigned  mask = _SERVICES_NAME_HASH_SIZE - 1;
+    unsigned  n    = _servent_name_hash(name) & mask;
+    int       len  = strlen(name);
+
+    for ( ; _services_name_hash[n] != 0; n = (n + 1) & mask) {
+        const char*  rec = _services + _services_name_hash[n] - 1;
+        const char*  p   = rec;
+        int          count;
+
+        if (p[0] == len && !memcmp(p+1, name, len))
+            goto gotname;
+
+        p    += 1 + p[0];
+        count = p[3];
+        p    += 4;
+        for ( ; count > 0; count--) {
+            if (p[0] == len && !memcmp(p+1, name, len))
+                goto gotname;
+            p += 1 + p[0];
+        }
+        continue;
+
+    gotname:
+        if (!_servent_proto_match(rec + 1 + rec[0], proto))
+            continue;
+
+        if (_servent_fill(rs, rec) == NULL)
+            return NULL;
+
+        return &rs->servent;
+    }
+    return NULL;
+}
+
+struct servent *
+_servent_byport( res_static  rs, int  port, const char*  proto )
+{
+    unsigned  mask = _SERVICES_PORT_HASH_SIZE - 1;
+    unsigned  n    = _servent_port_hash(port) & mask;
+
+    for ( ; _services_port_hash[n] != 0; n = (n + 1) & mask) {
+        const char*  rec = _services + _services_port_hash[n] - 1;
+        const char*  p   = rec + 1 + rec[0];
+        int          recport = (((unsigned char*)p)[0] << 8) |
+                                ((unsigned char*)p)[1];
+
+        if (recport != port || !_servent_proto_match(p, proto))
+            continue;
+
+        if (_servent_fill(rs, rec) == NULL)
+            return NULL;
+
+        return &rs->servent;
+    }
+    return NULL;
+}
+
 struct servent *
 getservent(void)
 {
@@ -42,3 +42,5 @@
 #include "resolv_static.h"
 
 struct servent*  getservent_r(res_static rs);
+struct servent*  _servent_byname(res_static rs, const char* name, const char* proto);
+struct servent*  _servent_byport(res_static rs, int port, const char* proto);
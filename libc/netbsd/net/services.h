@@ -478,3 +478,395 @@ static const char  _services[] = "\
 \4fido\353\23t\0\
 \0";
 
+/* offsets+1 of the records in _services, 0 if empty */
+#define  _SERVICES_NAME_HASH_SIZE  2048
+static const unsigned short  _services_name_hash[_SERVICES_NAME_HASH_SIZE] = {
+     2607,     0,     0,     0,  4015,  4023,     0,   956,
+      978,  1248,  1263,  5977,  2793,  2802,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  2997,
+     3008,     0,     0,     0,     0,     0,  2957,  2967,
+     5515,     0,     0,     0,     0,   223,     0,  5308,
+        0,     0,     0,     0,     0,  6507,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  6357,     0,  5935,  1080,  1088,   783,
+      802,  6156,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  1000,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  6156,  5698,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  4847,  4868,  6272,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,  3929,  3948,
+        0,     0,     0,     0,  2618,     0,     0,     0,
+        0,     0,     0,     0,     0,   765,     0,     0,
+     4657,  4675,     0,     0,  4549,  4567,     0,  3481,
+     3505,     0,     0,     0,     0,  4757,  4770,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  5953,   611,     0,     0,
+        0,     0,     0,  3039,  3051,  1516,  1529,     0,
+        0,   649,   690,   360,     0,     0,     0,  5489,
+     5502,     0,     0,     0,     0,     0,     0,   649,
+      690,  2335,     0,    74,     0,     0,   885,   911,
+        0,  4947,  4961,     0,     0,     0,     0,     0,
+        0,  1057,     0,  4047,  4059,     0,     0,     0,
+        0,     0,     0,     0,  2138,  2168,     0,     0,
+        0,     0,  1992,  2002,     0,     0,     0,  4293,
+     4303,  4131,  4161,  5668,  5586,  2483,  5603,  5708,
+     6426,     0,     0,     0,     0,   400,   415,     0,
+        0,     0,     0,  5544,     0,  3411,  3422,     0,
+        0,   271,     0,     0,     0,     0,     0,     0,
+     4353,  1154,  1169,  4363,     0,     0,  6190,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  2064,  2073,     0,     0,     0,
+     2665,     0,     0,     0,     0,     0,     0,  1752,
+     1764,  3889,  2693,  2709,  3900,     0,     0,   885,
+      911,     0,     0,  1542,  1043,  1550,     0,  6463,
+     6475,  3767,  3776,  5221,  5241,  5644,     0,     0,
+        0,  6203,     0,     0,     0,  6310,     0,     0,
+        0,     0,     0,     0,  2558,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  6055,
+     6067,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,   821,   841,     0,     0,  4621,  4639,
+        0,     0,     0,  3355,  3383,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,  5279,     0,
+        0,    30,    52,     0,  3721,  3736,     0,     0,
+        0,  6439,     0,     0,  5786,     0,     0,  3825,
+     2618,  3839,     0,     0,     0,     0,     0,     0,
+     5881,  5894,     0,  1732,  1742,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  2517,   611,   624,  3697,  3709,
+     4071,  4101,     0,     0,     0,  5818,  4467,  4484,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  6391,  6402,     0,     0,     0,
+      649,   690,  2122,  2130,     0,   158,   184,  5261,
+        0,     0,    30,    52,     0,     0,     0,  3545,
+      158,   127,   184,     0,     0,     0,     0,     0,
+        0,     0,  1500,  1508,     0,     0,     0,  3929,
+     3873,  3881,  3948,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     4725,  1600,  1611,  4741,     0,     0,     0,  3301,
+     3328,     0,     0,     0,     0,     0,     0,     0,
+        0,  6135,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+      585,  5013,  5022,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,  6251,     0,     0,
+     1034,     0,     0,     0,     0,  5327,  3269,  3285,
+     5460,  5945,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,  3751,  3759,  5720,   731,     0,  1057,  2537,
+     3137,  3162,     1,     0,     0,     0,     0,     0,
+        0,   323,     0,     0,  5161,  5191,  4693,  4709,
+        0,   926,   941,  5353,  2326,     0,     0,     0,
+        0,  1000,  1278,  1287,     0,     0,     0,     0,
+        0,     0,   115,  3825,  3839,     0,     0,     0,
+        0,     0,     0,  5871,     0,     0,     0,     0,
+        0,     0,  4313,  4323,  3621,  2811,  3636,  3911,
+     2462,  3920,  4501,  4525,     0,     0,     0,     0,
+        0,     0,     0,  6533,     0,     0,     0,  2361,
+     2104,  2113,     0,     0,     0,     0,  1216,  1232,
+        0,     0,     0,  4373,  4383,     0,     0,     0,
+     5103,  5112,  1000,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  6024,     0,     0,     0,     0,     0,
+        0,     0,     0,  2250,  2280,  2388,     0,     0,
+     4847,  4868,     0,     0,     0,     0,  1622,  1634,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,   783,   802,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,  3137,  3162,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,  1057,     0,
+        0,     0,  4783,  4799,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,   260,     0,     0,
+        0,     0,     0,     0,     0,     0,   482,   496,
+        0,     0,   231,  1438,  1438,  1469,  1469,     0,
+        0,     0,     0,  4031,  3529,  4039,  4585,  4603,
+     2592,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,   510,   521,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,   340,   430,   452,  2310,  2318,     0,  2462,
+        0,     0,  1438,  1469,     0,     0,     0,     0,
+        0,     0,  2977,  2987,     0,     0,     0,  3433,
+     3446,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  3591,  3606,     0,     0,     0,
+     1368,  1383,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  2570,  2581,     0,  6343,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,  5051,  5067,     0,     0,     0,     0,     0,
+        0,     0,     0,  2517,    30,    52,  5416,  5829,
+      956,   978,     0,  5362,     0,     0,     0,  4815,
+     4831,     0,     0,     0,     0,     0,  4191,  4204,
+        0,     0,     0,     0,     0,  3853,  3863,     0,
+     1796,  1808,  2828,  2840,  6371,  6381,     0,     0,
+        0,  4265,  4279,  5161,  5191,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,   127,
+        0,     0,     0,     0,    91,   103,  1852,  1866,
+        0,     0,     0,     0,   285,   304,     0,  2399,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,  6181,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  2537,
+     4975,  2374,  4986,     0,  2012,  2021,  5576,     0,
+     2082,  2093,  5402,     0,     0,  2755,  1880,  1904,
+     2765,  4333,  4343,     0,     0,     0,  2138,  2168,
+        0,     0,     0,     0,     0,     0,  4131,  4161,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,  4393,  4403,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     5689,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  4501,  4525,     0,     0,     0,     0,
+     1974,  1983,     0,  6033,  6044,     0,     0,  2419,
+     5679,     0,     0,     0,   532,   543,  2501,     0,
+        0,     0,     0,     0,     0,     0,     0,  1668,
+     1558,  1567,  1677,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     5531,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+      210,     0,     0,     0,    12,    21,  2250,  2030,
+     2047,  2280,     0,     0,     0,  1398,   285,   304,
+     1408,  5799,     0,     0,   632,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  4919,  4933,  3651,  3661,
+        0,     0,   360,     0,     0,     0,  1096,  1107,
+        0,     0,     0,  3459,  1928,  1942,  3470,     0,
+     5809,     0,     0,     0,  1686,  1701,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  3983,  3999,  3301,  3328,
+        0,     0,     0,  2919,  2929,     0,     0,     0,
+        0,     0,     0,     0,  2198,  2224,     0,     0,
+        0,  1820,  1248,  1263,  1836,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,   158,
+      184,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,  2438,     0,
+        0,     0,     0,    74,     0,     0,     0,     0,
+        0,     0,     0,     0,  3187,  3200,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,   271,     0,
+        0,     0,     0,     0,     0,  4889,  4904,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  1184,  1200,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,  3213,  3226,
+     6451,     0,     0,     0,     0,     0,     0,     0,
+        0,  2725,  2740,     0,   742,     0,  6126,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     2483,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  5121,  5132,  1296,  1319,
+     5965,     0,  2895,  2907,     0,     0,     0,     0,
+        0,     0,     0,     0,  3239,  3254,     0,  6283,
+        0,     0,  5344,     0,     0,     0,     0,     0,
+     5327,     0,     0,  1646,  1657,     0,  1118,  1136,
+     5620,  5632,     0,     0,  5143,  5152,  1880,  1904,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  5387,     0,     0,     0,     0,
+        0,  4413,  4423,  5742,  6413,  5561,     0,     0,
+        0,   765,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  5859,     0,     0,  5428,     0,
+        0,     0,     0,     0,     0,     0,  5445,     0,
+        0,     0,     0,     0,     0,     0,   340,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  5839,   142,   150,  3019,  3029,     0,
+        0,     0,     0,     0,   474,  6216,  6319,  6283,
+     6331,     0,     0,  3355,  3383,     0,     0,     0,
+        0,     0,     0,     0,     0,   861,   873,  2665,
+     5308,     0,     0,     0,  2665,  1342,  1355,     0,
+     5586,  5603,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+      563,   574,  2775,  2784,  5656,     0,     0,     0,
+        0,     0,     0,  6079,  6089,     0,     0,     0,
+        0,     0,  5992,     0,     0,     0,     0,     0,
+        0,     0,     0,  3095,  3105,  3785,  3794,  5760,
+     5773,  6517,  6525,     0,     0,     0,     0,     0,
+        0,     0,     0,  4217,  4241,     0,     0,     0,
+        0,     0,  3803,  3814,     0,     0,     0,     0,
+        0,     0,     0,     0,  1576,  1588,     0,     0,
+        0,   632,  2852,  2862,     0,     0,     0,     0,
+        0,     0,     0,  6099,  6108,     0,  5515,     0,
+        0,     0,  5279,     0,     0,  5435,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,   554,  2501,     0,     0,     0,
+      378,   389,     0,     0,   600,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  5730,  1716,  1724,     0,  5372,
+     5475,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     4433,  1776,  1786,  2335,  4450,     0,     0,     0,
+        0,     0,  6008,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,  3671,  3684,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  2198,  2224,     0,  1296,
+     1319,     0,  3575,  3583,     0,  1000,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  2635,
+     2650,     0,     0,     0,  2438,     0,  2693,  2709,
+     6547,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  3115,  3126,     0,     0,  2438,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,   885,  5161,  5191,     0,     0,
+        0,     0,  2351,  4071,  4101,     0,     0,     0,
+        0,     0,     0,     0,     0,   585,     0,     0,
+        0,     0,     0,     0,     0,  3967,  3975,  3560,
+        0,  6557,     0,     0,  4997,  5005,  4217,  4241,
+     5031,   244,   252,  5041,  4265,  4279,     0,     0,
+        0,     0,     0,     0,     0,  5977,     0,     0,
+        0,  6227,  2886,  6239,     0,     0,  5751,  6487,
+     6497,     0,   231,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  3063,  3079,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+      649,   690,  6146,     0,     0,     0,     0,     0,
+        0,     0,  6117,     0,   926,   941,     0,     0,
+        0,     0,     0,     0,     0,  1686,  1701,     0,
+        0,     0,     0,     0,  1956,  1965,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  5848,  5907,  5921,     0,     0,
+     2939,  2948,     0,  5279,     0,  1118,  1136,     0,
+        0,     0,     0,  2428,     0,   742,     0,     0,
+     6156,  3481,  3505,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,  2872,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  1418,
+     1428,  3433,  3446,  2374,  2592,  5083,  5093,     0,
+        0,   430,   452,  2361,   821,   323,   841,     0,
+        0,     0,     0,     0,     0,     0,     0,  2399,
+};
+#define  _SERVICES_PORT_HASH_SIZE  1024
+static const unsigned short  _services_port_hash[_SERVICES_PORT_HASH_SIZE] = {
+     2693,  2709,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,  2104,  2113,  5730,
+        0,     0,     0,     0,     0,   482,   496,     0,
+        0,     0,  3967,  3975,     0,     0,     0,  1216,
+     1232,     0,     0,  6251,     0,     0,     0,  3063,
+     1716,  1724,  3079,  6190,     0,  1852,  1866,  2138,
+     2168,     0,     0,     0,  1622,  1634,  4265,  2012,
+     2021,  4279,  6033,  6044,     0,     0,     0,     0,
+     2428,     0,     0,     0,     0,     0,     0,     0,
+        0,  5829,     0,     0,  3545,     0,     0,  2811,
+        0,  2872,     0,     0,     0,   210,     0,  4975,
+     4986,  2082,  2093,  1418,  1428,  6426,     0,     0,
+        0,     0,    74,     0,     0,     0,     0,     0,
+     4919,  3853,  3863,  4757,  4770,  4933,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,  3269,
+     3285,     0,     0,     0,  2665,     0,     0,     0,
+        0,  4031,  4039,     0,   510,   521,     0,     0,
+     3187,  3200,     0,     0,     0,     0,  5992,     0,
+        0,     0,  5143,  5152,     0,  2570,  2581,     0,
+        0,     0,     0,     0,  1928,  1942,   378,   389,
+     2250,  2280,  3785,  1646,  1657,  3794,  4313,  1080,
+     1088,  3459,  3470,  4323,  6227,  6239,  6487,  2438,
+     3355,  3383,  5308,  6497,     0,     0,     0,     0,
+     5848,     0,     0,     0,     0,  5221,  5241,  5698,
+      821,   841,  1752,  1764,   244,   252,  6343,  6451,
+     5121,  5132,  1500,  1508,  3671,  3684,     0,     0,
+        0,    91,   103,  5965,     0,     0,     0,     0,
+        0,     0,   632,  4815,  4831,  6507,     0,     0,
+        0,     0,     0,  1278,  1287,     0,     0,  4501,
+     4525,     0,     0,     0,     0,     0,     0,  3803,
+     3814,     0,     0,   554,     0,     0,     0,     0,
+        0,     0,  3137,  3162,  1248,  1263,  2793,  2802,
+        0,     0,     0,     0,  2592,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,  2517,  3019,  3029,  4353,  4363,     0,     0,
+        0,   340,     0,     0,     0,     0,  4217,  1558,
+     1567,  4241,  5013,  5022,     0,     0,     0,  5871,
+     6216,     0,  2351,  2361,     0,     0,     0,   861,
+      873,  1796,  1808,  2919,  2725,  2740,  2929,     0,
+        0,     0,     0,  3721,  3736,  5475,     0,  5344,
+      115,     0,     0,  6371,  6381,     0,     0,     0,
+        0,  3591,  3606,     0,     0,     0,     0,     0,
+        0,     0,  1342,  1355,     0,  5708,   611,   624,
+     4585,  4603,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,  4467,  4484,
+     3911,  3920,  5720,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,   430,   452,  3767,  3776,
+     2558,  1686,  1701,  4393,  4403,  5945,     0,     0,
+        0,  2122,  2130,     0,     0,     0,  1576,  1588,
+     5051,  5067,  6126,     0,     0,     0,     0,     0,
+        0,  2399,     0,     0,     0,  2957,   885,   911,
+     2967,  5435,  5751,  5799,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,   127,
+        0,     0,     0,     0,  1398,  1408,  5679,  5907,
+     5387,  5921,     0,     0,  3751,  3759,     0,     0,
+        0,     0,     0,     0,     0,  4657,  4675,  6079,
+     6089,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  2755,  2765,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,  2618,     0,     0,     0,     0,  1184,
+     1200,  5760,  5773,     0,     0,     0,     0,     0,
+     5953,  5531,     0,     0,  1096,  1107,  1820,  1836,
+        0,     0,     0,     0,  2483,     0,     0,  1992,
+     2002,  5083,  5093,     0,   285,   304,  3575,  3583,
+     2419,  2977,  1542,  1550,  2987,   956,   978,  6117,
+        0,     0,  5818,     0,     0,  3529,     0,     0,
+        0,  6283,   765,  4997,  5005,     0,   158,   184,
+     6413,     0,     0,     0,     0,  6310,     0,  5416,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,  4889,  4904,     0,  4725,  4741,  5656,     1,
+     5460,  6024,     0,     0,     0,     0,     0,  4191,
+     3239,  3254,  4204,     0,     0,  3825,  3839,     0,
+        0,     0,     0,  1956,  1965,  3621,  3636,     0,
+        0,     0,  5353,     0,     0,     0,     0,     0,
+        0,     0,   474,     0,     0,     0,     0,     0,
+     5544,     0,     0,     0,  6547,  1880,  1904,  2198,
+     2224,  6463,  6475,  4293,  4303,     0,  2030,  2047,
+     6055,  6067,     0,   323,  5977,     0,     0,     0,
+     3301,  3328,     0,     0,  1000,     0,     0,     0,
+        0,  5839,     0,     0,  3560,     0,  5161,  5191,
+     2886,   783,   802,  5689,   223,   231,     0,  6319,
+     6331,  5103,  1438,  1469,  4847,  3651,   731,  3661,
+     4868,  5112,  6439,  3433,  3446,     0,     0,     0,
+     4947,  4961,     0,  4783,  4799,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,   585,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     4047,  4059,     0,     0,   532,   543,  2310,  2318,
+     2635,  2650,  3039,  3051,  3213,  3226,  5445,  5515,
+     6008,  6181,     0,     0,     0,     0,     0,  5561,
+        0,     0,     0,  6557,     0,   400,   415,     0,
+        0,  2501,  2997,  3008,  4333,  4343,  6146,  6156,
+     3481,  3505,  5362,     0,     0,     0,     0,     0,
+     5327,     0,  5620,  1034,  3115,  3126,  5632,  3873,
+     3881,  5859,  6203,  2326,  2335,  5261,     0,  2895,
+     2907,  5489,  1776,   260,  1786,  5502,  6357,     0,
+        0,     0,     0,     0,  3697,  3709,     0,     0,
+        0,     0,     0,     0,     0,     0,  3889,  3900,
+        0,   649,   690,  3095,  3105,     0,     0,     0,
+     5586,  5603,     0,  1296,  1319,     0,   600,  4549,
+     4567,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,   563,   574,  2852,  2862,  4433,
+     4450,     0,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+        0,  1118,  1136,     0,     0,  5644,  6391,  6402,
+     2537,  4373,  1668,  1677,  4383,     0,     0,     0,
+        0,   360,     0,     0,     0,     0,  3411,  3422,
+     5935,  5031,  1043,  5041,     0,     0,     0,     0,
+        0,     0,  2374,  1516,  1529,  2388,  2939,  2948,
+     5279,     0,   271,  5786,     0,     0,     0,     0,
+        0,     0,     0,     0,  5428,     0,     0,     0,
+        0,     0,     0,     0,     0,     0,     0,     0,
+     5881,  5372,  5894,     0,    12,    21,     0,     0,
+     2064,  1368,  1383,  2073,  6272,  4621,  4639,     0,
+        0,  5742,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  4071,  3983,  3999,  4101,
+     3929,  3948,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,  2607,  1732,  1742,  5576,     0,
+     1154,  1169,     0,     0,     0,     0,     0,     0,
+     4413,  4423,     0,     0,     0,     0,     0,     0,
+        0,     0,     0,     0,  2462,     0,  1600,  1611,
+     2828,  1057,  2840,  4131,  4161,  6135,     0,     0,
+        0,     0,     0,     0,     0,     0,   926,   941,
+     5668,     0,  5809,     0,     0,     0,     0,     0,
+        0,     0,     0,   742,     0,     0,   142,   150,
+        0,     0,     0,     0,     0,     0,     0,  4015,
+     2775,  2784,  4023,    30,    52,  5402,  6517,  6525,
+     6533,     0,  1974,  1983,  4693,  4709,  6099,  6108,
+};
+
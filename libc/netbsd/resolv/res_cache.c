@@ -28,18 +28,29 @@
 
 #include "resolv_cache.h"
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include "pthread.h"
+#include "arpa_nameser.h"
+#include <sys/system_properties.h>
 
 /* this code implements a small DNS resolver cache for all gethostbyname* functions
  *
  * the cache is shared between all threads of the current process, but the result of
  * a succesful lookup is always copied to a thread-local variable to honor the persistence
  * rules of the gethostbyname*() APIs.
+ *
+ * it also keeps raw DNS answers, keyed on the query packet, on behalf of res_nsend().
+ * this is what getaddrinfo() and the res_query*() functions go through. these answers
+ * expire according to the TTLs they carry.
+ *
+ * everything is flushed whenever the 'net.change' system property is updated, since
+ * this means the network configuration (and likely the DNS servers) changed.
  */
 
 /* the name of an environment variable that will be checked the first time this code is called
- * if its value is "0", then the resolver cache is disabled.
+ * if its value is "0", then the resolver cache is disabled. if it is a number larger than 1,
+ * it is used instead of CONFIG_MAX_ENTRIES.
  */
 #define  CONFIG_ENV  "BIONIC_DNSCACHE"
 
@@ -48,11 +59,20 @@
  */
 #define  CONFIG_SECONDS    (60*10)    /* 10 minutes */
 
-/* maximum number of entries kept in the cache. be frugal, this is the C library
- * this MUST BE A POWER OF 2
+/* default maximum number of entries kept in the cache, for each kind of entry.
+ * be frugal, this is the C library. this can be changed with CONFIG_ENV.
  */
 #define  CONFIG_MAX_ENTRIES   128
 
+/* number of independently locked parts of the cache. MUST BE A POWER OF 2
+ */
+#define  CONFIG_SHARDS        8
+
+/* cached DNS answers never live longer than CONFIG_MAX_TTL seconds, whatever their
+ * records say. 'net.change' is not updated on every network change that matters.
+ */
+#define  CONFIG_MAX_TTL    (60*60)    /* 1 hour */
+
 /****************************************************************************/
 /****************************************************************************/
 /*****                                                                  *****/
@@ -207,75 +227,211 @@ _resolv_hostent_free( struct hostent*  hp )
 /****************************************************************************/
 /****************************************************************************/
 
-typedef struct Entry {
+/* both kinds of cached items start with a Node. nodes are kept in a chained hash
+ * table for lookups, and in a circular list that is swept by the CLOCK algorithm
+ * to pick eviction victims: a hit only sets the node's 'referenced' flag (and only
+ * if it isn't set yet), instead of relinking it at the head of an MRU list. this
+ * means lookups never modify the table itself, and can run concurrently under a
+ * read lock.
+ */
+typedef struct Node {
     unsigned int     hash;
-    const char*      name;
-    short            af;
-    short            index;
-    struct Entry*    mru_prev;
-    struct Entry*    mru_next;
-    time_t           when;
-    struct hostent*  hp;
-} Entry;
+    struct Node*     hlink;       /* next node in the same hash bucket */
+    struct Node*     clock_prev;
+    struct Node*     clock_next;
+    int volatile     referenced;
+    time_t           expires;
+} Node;
+
+typedef struct {
+    int       num_nodes;
+    int       max_nodes;
+    unsigned  mask;               /* number of buckets - 1 */
+    Node**    buckets;
+    Node*     hand;               /* CLOCK hand, NULL if the table is empty */
+} Table;
+
+
+static int
+table_init( Table*  t, int  max_nodes )
+{
+    unsigned  num_buckets = 1;
+
+    while (num_buckets < 2U*max_nodes)
+        num_buckets <<= 1;
+
+    t->buckets = calloc(num_buckets, sizeof(Node*));
+    if (t->buckets == NULL)
+        return -1;
+
+    t->num_nodes = 0;
+    t->max_nodes = max_nodes;
+    t->mask      = num_buckets - 1;
+    t->hand      = NULL;
+    return 0;
+}
 
 
 static void
-entry_free( Entry*  e )
+table_flush( Table*  t, void  (*free_node)(Node*) )
 {
-    /* everything is allocated in a single memory block */
-    if (e) {
-        _resolv_hostent_free(e->hp);
-        free(e);
+    unsigned  nn;
+
+    for (nn = 0; nn <= t->mask; nn++) {
+        Node*  n = t->buckets[nn];
+
+        while (n != NULL) {
+            Node*  next = n->hlink;
+            free_node(n);
+            n = next;
+        }
+        t->buckets[nn] = NULL;
     }
+    t->num_nodes = 0;
+    t->hand      = NULL;
 }
 
+
+static __inline__ Node**
+table_bucket( Table*  t, unsigned  hash )
+{
+    return &t->buckets[ hash & t->mask ];
+}
+
+
+/* 'pnode' is the link pointing to the node, as returned by the find functions */
 static void
-entry_init_key( Entry*  e, const char*  name, int  af )
+table_remove( Table*  t, Node**  pnode, void  (*free_node)(Node*) )
 {
-    unsigned     h = 0;
-    const char*  p = name;
+    Node*  n = *pnode;
 
-    /* compute hash */
-    p = name;
-    while (*p) {
-        h = h*33 + *p++;
+    *pnode = n->hlink;
+
+    if (n->clock_next == n) {
+        t->hand = NULL;
+    } else {
+        if (t->hand == n)
+            t->hand = n->clock_next;
+        n->clock_prev->clock_next = n->clock_next;
+        n->clock_next->clock_prev = n->clock_prev;
     }
-    h += af*17;
+    free_node(n);
+    t->num_nodes -= 1;
+}
+
 
-    e->hash = h;
-    e->name = name;
-    e->af   = (short) af;
+/* advance the CLOCK hand until it points to a node that wasn't referenced since
+ * the last sweep, clearing the flags on its way, and evict that node. expired
+ * nodes are taken first.
+ */
+static void
+table_evict( Table*  t, time_t  now, void  (*free_node)(Node*) )
+{
+    Node*   victim = t->hand;
+    Node**  pnode;
+
+    for (;;) {
+        if (now >= victim->expires || !victim->referenced)
+            break;
+        victim->referenced = 0;
+        victim = victim->clock_next;
+    }
+
+    t->hand = victim;
+    pnode   = table_bucket(t, victim->hash);
+    while (*pnode != victim)
+        pnode = &(*pnode)->hlink;
+
+    table_remove(t, pnode, free_node);
 }
 
 
-static __inline__ void
-entry_mru_remove( Entry*  e )
+/* new nodes are inserted just behind the hand, i.e. they are the last ones the
+ * next sweep will look at.
+ */
+static void
+table_insert( Table*  t, Node*  n, time_t  now, void  (*free_node)(Node*) )
 {
-    e->mru_prev->mru_next = e->mru_next;
-    e->mru_next->mru_prev = e->mru_prev;
+    Node**  pbucket;
+
+    if (t->num_nodes >= t->max_nodes)
+        table_evict(t, now, free_node);
+
+    pbucket    = table_bucket(t, n->hash);
+    n->hlink   = *pbucket;
+    *pbucket   = n;
+    n->referenced = 0;
+
+    if (t->hand == NULL) {
+        n->clock_prev = n->clock_next = n;
+        t->hand = n;
+    } else {
+        Node*  hand = t->hand;
+
+        n->clock_next = hand;
+        n->clock_prev = hand->clock_prev;
+        hand->clock_prev->clock_next = n;
+        hand->clock_prev = n;
+    }
+    t->num_nodes += 1;
 }
 
+
+/* mark a node as recently used. avoid dirtying its cache line when the flag is
+ * already set, which is the common case for hot entries.
+ */
 static __inline__ void
-entry_mru_add( Entry*  e, Entry*  list )
+node_touch( Node*  n )
 {
-    Entry*  first = list->mru_next;
+    if (!n->referenced)
+        n->referenced = 1;
+}
+
+/****************************************************************************/
+/****************************************************************************/
+/*****                                                                  *****/
+/*****                                                                  *****/
+/*****                                                                  *****/
+/****************************************************************************/
+/****************************************************************************/
+
+typedef struct Entry {
+    Node             node;
+    const char*      name;
+    short            af;
+    struct hostent*  hp;
+} Entry;
+
+
+static void
+entry_free( Node*  n )
+{
+    /* everything is allocated in a single memory block */
+    Entry*  e = (Entry*) n;
+
+    _resolv_hostent_free(e->hp);
+    free(e);
+}
+
+static unsigned
+entry_hash( const char*  name, int  af )
+{
+    unsigned     h = 0;
+    const char*  p = name;
 
-    e->mru_next = first;
-    e->mru_prev = list;
+    while (*p) {
+        h = h*33 + *p++;
+    }
+    h += af*17;
 
-    list->mru_next  = e;
-    first->mru_prev = e;
+    return h;
 }
 
 
 static Entry*
-entry_alloc( const char*  name, int  af, int  index, struct hostent*  hp )
+entry_alloc( const char*  name, int  af, unsigned  hash, struct hostent*  hp )
 {
     Entry*  e;
-    int     num_aliases   = 0;
-    int     num_addresses = 0;
-    char**  aliases;
-    char**  addresses;
 
     /* compute the length of the memory block that will contain everything */
     int   len = sizeof(*e) + strlen(name)+1;
@@ -284,12 +440,10 @@ entry_alloc( const char*  name, int  af, int  index, struct hostent*  hp )
     if (e == NULL)
         return e;
 
-    entry_init_key(e, name, af);
-
-    e->mru_next = e->mru_prev = e;
-    e->index    = (short) index;
-    e->when     = _time_now();
-    e->hp       = _resolv_hostent_copy(hp);
+    e->node.hash    = hash;
+    e->node.expires = _time_now() + CONFIG_SECONDS;
+    e->af           = (short) af;
+    e->hp           = _resolv_hostent_copy(hp);
 
     if (e->hp == NULL) {
         free(e);
@@ -303,10 +457,22 @@ entry_alloc( const char*  name, int  af, int  index, struct hostent*  hp )
 }
 
 
-static __inline__ int
-entry_equals( const Entry*  e1, const Entry*  e2 )
+/* a raw DNS answer. the query and answer packets are stored in the same memory
+ * block, right after the structure.
+ */
+typedef struct Answer {
+    Node              node;
+    int               querylen;
+    int               answerlen;
+    const u_char*     query;
+    const u_char*     answer;
+} Answer;
+
+
+static void
+answer_free( Node*  n )
 {
-    return e1->hash == e2->hash && e1->af == e2->af && !strcmp( e1->name, e2->name );
+    free(n);
 }
 
 /****************************************************************************/
@@ -317,26 +483,111 @@ entry_equals( const Entry*  e1, const Entry*  e2 )
 /****************************************************************************/
 /****************************************************************************/
 
-#define  MAX_HASH_ENTRIES   (2*CONFIG_MAX_ENTRIES)
+/* the cache is split into CONFIG_SHARDS independent shards, selected by key hash,
+ * each with its own lock. hits only take the shard's lock for reading, so they
+ * don't exclude each other.
+ */
+typedef struct {
+    pthread_rwlock_t  lock;
+    unsigned          net_change_serial;   /* serial the content is valid for */
+    Table             entries;
+    Table             answers;
+} Shard;
 
 typedef struct resolv_cache {
-    int               num_entries;
-    Entry             mru_list;
-    pthread_mutex_t   lock;
     int               disabled;
-    Entry*            entries[ MAX_HASH_ENTRIES ];      /* hash-table of pointers to entries */
+    const prop_info*  net_change;
+    Shard             shards[ CONFIG_SHARDS ];
 } Cache;
 
 
+static __inline__ Shard*
+_resolv_cache_shard( Cache*  cache, unsigned  hash )
+{
+    /* the low bits select the bucket within the shard */
+    return &cache->shards[ (hash >> 24) % CONFIG_SHARDS ];
+}
+
+
+/* return the current serial of 'net.change', or 0 if it doesn't exist (yet) */
+static unsigned
+_resolv_cache_net_serial( Cache*  cache )
+{
+    const prop_info*  pi = cache->net_change;
+
+    if (pi == NULL) {
+        pi = __system_property_find("net.change");
+        if (pi == NULL)
+            return 0;
+        cache->net_change = pi;
+    }
+    return __system_property_serial(pi);
+}
+
+
+/* must be called with the shard locked for writing */
+static void
+_resolv_shard_flush_locked( Shard*  shard )
+{
+    table_flush( &shard->entries, entry_free );
+    table_flush( &shard->answers, answer_free );
+}
+
+
+/* lock the shard for reading, first flushing it if 'net.change' moved since it
+ * was filled, which means the network configuration (and likely the DNS servers)
+ * changed.
+ */
+static void
+_resolv_shard_rdlock( Shard*  shard, unsigned  serial )
+{
+    pthread_rwlock_rdlock( &shard->lock );
+    if (shard->net_change_serial == serial)
+        return;
+
+    pthread_rwlock_unlock( &shard->lock );
+    pthread_rwlock_wrlock( &shard->lock );
+    if (shard->net_change_serial != serial) {
+        XLOG("%s: net.change serial %u -> %u, flushing\n", __FUNCTION__,
+             shard->net_change_serial, serial);
+        _resolv_shard_flush_locked( shard );
+        shard->net_change_serial = serial;
+    }
+    /* the caller will only read, and there is nothing left to read anyway */
+}
+
+
+static void
+_resolv_shard_wrlock( Shard*  shard, unsigned  serial )
+{
+    pthread_rwlock_wrlock( &shard->lock );
+    if (shard->net_change_serial != serial) {
+        XLOG("%s: net.change serial %u -> %u, flushing\n", __FUNCTION__,
+             shard->net_change_serial, serial);
+        _resolv_shard_flush_locked( shard );
+        shard->net_change_serial = serial;
+    }
+}
+
+
 void
 _resolv_cache_destroy( struct resolv_cache*  cache )
 {
     if (cache != NULL) {
         int  nn;
-        for (nn = 0; nn < MAX_HASH_ENTRIES; nn++) {
-            entry_free(cache->entries[nn]);
+        for (nn = 0; nn < CONFIG_SHARDS; nn++) {
+            Shard*  shard = &cache->shards[nn];
+
+            if (shard->entries.buckets != NULL) {
+                table_flush( &shard->entries, entry_free );
+                free( shard->entries.buckets );
+            }
+            if (shard->answers.buckets != NULL) {
+                table_flush( &shard->answers, answer_free );
+                free( shard->answers.buckets );
+            }
+            pthread_rwlock_destroy( &shard->lock );
         }
-        pthread_mutex_destroy(&cache->lock);
         free(cache);
     }
 }
@@ -350,59 +601,64 @@ _resolv_cache_create( void )
     cache = calloc(sizeof(*cache), 1);
     if (cache) {
         const char*  env = getenv(CONFIG_ENV);
+        int          max_entries = CONFIG_MAX_ENTRIES;
+        int          shard_entries;
+        unsigned     serial;
+        int          nn;
+
+        if (env) {
+            int  value = atoi(env);
+
+            if (value == 0)
+                cache->disabled = 1;
+            else if (value > 1)
+                max_entries = value;
+        }
 
-        if (env && atoi(env) == 0)
-            cache->disabled = 1;
+        shard_entries = (max_entries + CONFIG_SHARDS - 1) / CONFIG_SHARDS;
+        serial        = _resolv_cache_net_serial(cache);
 
-        pthread_mutex_init( &cache->lock, NULL );
-        cache->mru_list.mru_prev = cache->mru_list.mru_next = &cache->mru_list;
-        XLOG("%s: cache=%p %s\n", __FUNCTION__, cache, cache->disabled ? "disabled" : "enabled" );
+        for (nn = 0; nn < CONFIG_SHARDS; nn++) {
+            Shard*  shard = &cache->shards[nn];
+
+            pthread_rwlock_init( &shard->lock, NULL );
+            shard->net_change_serial = serial;
+            if (table_init( &shard->entries, shard_entries ) < 0 ||
+                table_init( &shard->answers, shard_entries ) < 0) {
+                _resolv_cache_destroy(cache);
+                return NULL;
+            }
+        }
+        XLOG("%s: cache=%p %s max_entries=%d\n", __FUNCTION__, cache,
+             cache->disabled ? "disabled" : "enabled", max_entries );
     }
     return cache;
 }
 
 
-static int
-_resolv_cache_find_index( Cache*       cache,
-                          const char*  name,
-                          int          af )
+/* return the address of the link pointing to the entry matching 'name' and 'af',
+ * or of the NULL link terminating its bucket if there is none.
+ */
+static Node**
+_resolv_shard_find_entry_p( Shard*       shard,
+                            unsigned     hash,
+                            const char*  name,
+                            int          af )
 {
-    Entry  key;
-    int    nn, step, tries;
+    Node**  pnode = table_bucket( &shard->entries, hash );
 
-    entry_init_key( &key, name, af );
+    for (;;) {
+        Entry*  e = (Entry*) *pnode;
 
-    tries = MAX_HASH_ENTRIES;
-    nn    = key.hash % MAX_HASH_ENTRIES;
-    step  = 5;
-
-    while (tries > 0) {
-        Entry*  key2 = cache->entries[nn];
-
-        if (key2 == NULL) {
-            return -(nn + 1);
-        }
+        if (e == NULL)
+            break;
 
-        if (entry_equals( &key, key2 ) ) {
-            return nn;
-        }
+        if (e->node.hash == hash && e->af == af && !strcmp(e->name, name))
+            break;
 
-        nn     = (nn + step) % MAX_HASH_ENTRIES;
-        tries -= 1;
+        pnode = &e->node.hlink;
     }
-    return -(MAX_HASH_ENTRIES+1);
-}
-
-
-static void
-_resolv_cache_remove( struct resolv_cache*  cache,
-                      Entry*                e )
-{
-    XLOG("%s: name='%s' af=%d\n", __FUNCTION__, e->name, e->af);
-    cache->entries[ e->index ] = NULL;  /* remove from hash table */
-    entry_mru_remove( e );
-    entry_free( e );
-    cache->num_entries -= 1;
+    return pnode;
 }
 
 
@@ -411,32 +667,30 @@ _resolv_cache_lookup( struct resolv_cache*  cache,
                       const char*           name,
                       int                   af )
 {
-    int               index;
+    unsigned          hash;
+    Shard*            shard;
+    Entry*            e;
     struct hostent*   result = NULL;
 
     if (cache->disabled)
         return NULL;
 
-    pthread_mutex_lock( &cache->lock );
+    hash  = entry_hash( name, af );
+    shard = _resolv_cache_shard( cache, hash );
+    _resolv_shard_rdlock( shard, _resolv_cache_net_serial(cache) );
 
     XLOG( "%s: cache=%p name='%s' af=%d ", __FUNCTION__, cache, name, af );
-    index = _resolv_cache_find_index( cache, name, af );
-    if (index >= 0) {
-        Entry*  e   = cache->entries[index];
-        time_t  now = _time_now();
+    e = (Entry*) *_resolv_shard_find_entry_p( shard, hash, name, af );
+    if (e != NULL) {
         struct hostent**  pht;
 
         /* ignore stale entries, they will be discarded in _resolv_cache_add */
-        if ( (unsigned)(now - e->when) >= CONFIG_SECONDS ) {
+        if ( _time_now() >= e->node.expires ) {
             XLOG( " OLD\n" );
             goto Exit;
         }
 
-        /* bump up this entry to the top of the MRU list */
-        if (e != cache->mru_list.mru_next) {
-            entry_mru_remove( e );
-            entry_mru_add( e, &cache->mru_list );
-        }
+        node_touch( &e->node );
 
         /* now copy the result into a thread-local variable */
         pht = __get_res_cache_hostent_p();
@@ -460,7 +714,7 @@ _resolv_cache_lookup( struct resolv_cache*  cache,
     }
     XLOG( " KO\n" );
 Exit:
-    pthread_mutex_unlock( &cache->lock );
+    pthread_rwlock_unlock( &shard->lock );
     return result;
 }
 
@@ -471,40 +725,262 @@ _resolv_cache_add( struct resolv_cache*  cache,
                    int                   af,
                    struct hostent*       hp )
 {
-    Entry*   e;
-    int      index;
+    unsigned  hash;
+    Shard*    shard;
+    Node**    pnode;
+    Entry*    e;
 
     if (cache->disabled)
         return;
 
-    pthread_mutex_lock( &cache->lock );
+    hash  = entry_hash( name, af );
+    shard = _resolv_cache_shard( cache, hash );
+
+    /* do the copy before taking the lock */
+    e = entry_alloc( name, af, hash, hp );
+    if (e == NULL)
+        return;
+
+    _resolv_shard_wrlock( shard, _resolv_cache_net_serial(cache) );
 
     XLOG( "%s: cache=%p name='%s' af=%d\n", __FUNCTION__, cache, name, af);
 
-    /* get rid of the oldest entry if needed */
-    if (cache->num_entries >= CONFIG_MAX_ENTRIES) {
-        Entry*  oldest = cache->mru_list.mru_prev;
-        _resolv_cache_remove( cache, oldest );
+    pnode = _resolv_shard_find_entry_p( shard, hash, name, af );
+    if (*pnode != NULL) {
+        /* discard stale entry */
+        table_remove( &shard->entries, pnode, entry_free );
     }
+    table_insert( &shard->entries, &e->node, _time_now(), entry_free );
 
-    index = _resolv_cache_find_index( cache, name, af );
-    if (index >= 0) {
-        /* discard stale entry */
-        _resolv_cache_remove( cache, cache->entries[index] );
-    } else {
-        index = -(index+1);
-        if (index >= MAX_HASH_ENTRIES)
-            goto Exit;  /* should not happen */
+    pthread_rwlock_unlock( &shard->lock );
+}
+
+/****************************************************************************/
+/****************************************************************************/
+/*****                                                                  *****/
+/*****                                                                  *****/
+/*****                                                                  *****/
+/****************************************************************************/
+/****************************************************************************/
+
+/* only plain queries with a single question are cached. an EDNS0 OPT record
+ * in the additional section is accepted, it becomes part of the key.
+ */
+static int
+answer_query_is_cacheable( const u_char*  query, int  querylen )
+{
+    ns_msg  msg;
+
+    if (querylen <= NS_HFIXEDSZ || ns_initparse(query, querylen, &msg) < 0)
+        return 0;
+
+    return ns_msg_getflag(msg, ns_f_qr) == 0          &&
+           ns_msg_getflag(msg, ns_f_opcode) == ns_o_query &&
+           ns_msg_count(msg, ns_s_qd) == 1            &&
+           ns_msg_count(msg, ns_s_an) == 0            &&
+           ns_msg_count(msg, ns_s_ns) == 0            &&
+           ns_msg_count(msg, ns_s_ar) <= 1;
+}
+
+
+/* return the number of seconds an answer can be cached, or 0 if it must not be.
+ * positive answers live as long as their shortest TTL. negative answers (NXDOMAIN
+ * or NODATA) live for the smaller of the SOA's TTL and MINIMUM field, as described
+ * in RFC 2308. anything else (errors, truncated replies, negative answers without
+ * a SOA) is not cached.
+ */
+static unsigned
+answer_get_ttl( const u_char*  answer, int  answerlen )
+{
+    ns_msg    msg;
+    ns_rr     rr;
+    unsigned  ttl = ~0U;
+    int       rcode, count, nn;
+
+    if (ns_initparse(answer, answerlen, &msg) < 0)
+        return 0;
+
+    if (ns_msg_getflag(msg, ns_f_tc))
+        return 0;
+
+    rcode = ns_msg_getflag(msg, ns_f_rcode);
+    count = ns_msg_count(msg, ns_s_an);
+
+    if (rcode == ns_r_noerror && count > 0) {
+        for (nn = 0; nn < count; nn++) {
+            if (ns_parserr(&msg, ns_s_an, nn, &rr) < 0)
+                return 0;
+            if (ns_rr_ttl(rr) < ttl)
+                ttl = ns_rr_ttl(rr);
+        }
+        return ttl;
     }
 
-    e = entry_alloc( name, af, index, hp );
-    if (e != NULL) {
-        entry_mru_add( e, &cache->mru_list );
-        cache->entries[index] = e;
-        cache->num_entries   += 1;
+    if (rcode != ns_r_noerror && rcode != ns_r_nxdomain)
+        return 0;
+
+    count = ns_msg_count(msg, ns_s_ns);
+    for (nn = 0; nn < count; nn++) {
+        if (ns_parserr(&msg, ns_s_ns, nn, &rr) < 0)
+            return 0;
+        /* MINIMUM is the last of the 5 integers ending the SOA rdata */
+        if (ns_rr_type(rr) == ns_t_soa && ns_rr_rdlen(rr) > 5*NS_INT32SZ) {
+            unsigned  minimum;
+
+            minimum = ns_get32(ns_rr_rdata(rr) + ns_rr_rdlen(rr) - NS_INT32SZ);
+            ttl     = ns_rr_ttl(rr);
+            return (minimum < ttl) ? minimum : ttl;
+        }
+    }
+    return 0;
+}
+
+
+/* the query ID in the first two bytes is not part of the key */
+static unsigned
+answer_hash_query( const u_char*  query, int  querylen )
+{
+    unsigned  h = 0;
+    int       nn;
+
+    for (nn = 2; nn < querylen; nn++)
+        h = h*33 + query[nn];
+
+    return h;
+}
+
+
+/* return the address of the link pointing to the answer matching 'query', or
+ * of the NULL link terminating its bucket if there is none.
+ */
+static Node**
+_resolv_shard_find_answer_p( Shard*         shard,
+                             unsigned       hash,
+                             const u_char*  query,
+                             int            querylen )
+{
+    Node**  pnode = table_bucket( &shard->answers, hash );
+
+    for (;;) {
+        Answer*  a = (Answer*) *pnode;
+
+        if (a == NULL)
+            break;
+
+        if (a->node.hash == hash && a->querylen == querylen &&
+            !memcmp(a->query + 2, query + 2, querylen - 2))
+            break;
+
+        pnode = &a->node.hlink;
+    }
+    return pnode;
+}
+
+
+int
+_resolv_cache_lookup_answer( struct resolv_cache*  cache,
+                             const void*           query,
+                             int                   querylen,
+                             void*                 answer,
+                             int                   answersize )
+{
+    const u_char*  q = query;
+    unsigned       hash;
+    Shard*         shard;
+    Answer*        a;
+    int            result = -1;
+
+    if (cache->disabled || !answer_query_is_cacheable(q, querylen))
+        return -1;
+
+    hash  = answer_hash_query(q, querylen);
+    shard = _resolv_cache_shard( cache, hash );
+    _resolv_shard_rdlock( shard, _resolv_cache_net_serial(cache) );
+
+    XLOG( "%s: cache=%p querylen=%d ", __FUNCTION__, cache, querylen );
+    a = (Answer*) *_resolv_shard_find_answer_p( shard, hash, q, querylen );
+    if (a == NULL) {
+        XLOG( " KO\n" );
+        goto Exit;
+    }
+
+    /* stale answers are replaced by _resolv_cache_add_answer, or evicted first */
+    if (_time_now() >= a->node.expires) {
+        XLOG( " OLD\n" );
+        goto Exit;
+    }
+
+    if (a->answerlen > answersize) {
+        XLOG( " TOOBIG\n" );
+        goto Exit;
     }
+
+    node_touch( &a->node );
+
+    /* the reply must carry the ID of the query it answers */
+    memcpy( answer, a->answer, a->answerlen );
+    memcpy( answer, q, 2 );
+    result = a->answerlen;
+    XLOG( " OK\n" );
 Exit:
-    pthread_mutex_unlock( &cache->lock );
+    pthread_rwlock_unlock( &shard->lock );
+    return result;
+}
+
+
+void
+_resolv_cache_add_answer( struct resolv_cache*  cache,
+                          const void*           query,
+                          int                   querylen,
+                          const void*           answer,
+                          int                   answerlen )
+{
+    const u_char*  q = query;
+    unsigned       hash, ttl;
+    Shard*         shard;
+    Node**         pnode;
+    Answer*        a;
+    time_t         now;
+
+    if (cache->disabled || !answer_query_is_cacheable(q, querylen))
+        return;
+
+    ttl = answer_get_ttl(answer, answerlen);
+    if (ttl == 0)
+        return;
+    if (ttl > CONFIG_MAX_TTL)
+        ttl = CONFIG_MAX_TTL;
+
+    hash  = answer_hash_query(q, querylen);
+    shard = _resolv_cache_shard( cache, hash );
+
+    /* do the copy before taking the lock */
+    a = malloc( sizeof(*a) + querylen + answerlen );
+    if (a == NULL)
+        return;
+
+    now = _time_now();
+    a->node.hash    = hash;
+    a->node.expires = now + ttl;
+    a->querylen     = querylen;
+    a->answerlen    = answerlen;
+    a->query        = (const u_char*)(a + 1);
+    a->answer       = a->query + querylen;
+    memcpy( (u_char*)a->query, query, querylen );
+    memcpy( (u_char*)a->answer, answer, answerlen );
+
+    _resolv_shard_wrlock( shard, _resolv_cache_net_serial(cache) );
+
+    XLOG( "%s: cache=%p querylen=%d ttl=%u\n", __FUNCTION__, cache, querylen, ttl );
+
+    pnode = _resolv_shard_find_answer_p( shard, hash, q, querylen );
+    if (*pnode != NULL) {
+        /* another thread raced us, or the entry is stale: replace it */
+        table_remove( &shard->answers, pnode, answer_free );
+    }
+    table_insert( &shard->answers, &a->node, now, answer_free );
+
+    pthread_rwlock_unlock( &shard->lock );
 }
 
 /****************************************************************************/
@@ -100,9 +100,11 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 #include <netdb.h>
 #ifdef ANDROID_CHANGES
 #include "resolv_private.h"
+#include "resolv_cache.h"
 #else
 #include <resolv.h>
 #endif
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -127,15 +129,31 @@ __RCSID("$NetBSD: res_send.c,v 1.9 2006/01/24 17:41:25 christos Exp $");
 
 static const int highestFD = FD_SETSIZE - 1;
 
+/* Results of check_dg_answer(). */
+#define DG_IGNORE	0	/* not an answer to our query, keep waiting */
+#define DG_REJECT	1	/* the server can't help, try another one */
+#define DG_TRUNCATED	2	/* retry over TCP with the same server */
+#define DG_ACCEPT	3
+
 /* Forward. */
 
 static int		get_salen __P((const struct sockaddr *));
 static struct sockaddr * get_nsaddr __P((res_state, size_t));
 static int		send_vc(res_state, const u_char *, int,
 				u_char *, int, int *, int);
+static void		sync_nsaddrs(res_state);
+static int		open_dg_socket(res_state, int, int *);
+static void		close_dg_socket(res_state, int);
+static int		check_dg_answer(res_state, const u_char *, int,
+					u_char *, int, int,
+					struct sockaddr *, int *);
 static int		send_dg(res_state, const u_char *, int,
-				u_char *, int, int *, int,
+				u_char *, int, const u_char *, int,
+				u_char *, int, int *, int *, int,
 				int *, int *);
+static int		send_dg_blast(res_state, const u_char *, int,
+				      u_char *, int, int *, int *,
+				      int *, int *);
 static void		Aerror(const res_state, FILE *, const char *, int,
 			       const struct sockaddr *, int);
 static void		Perror(const res_state, FILE *, const char *, int);
@@ -348,8 +366,11 @@ int
 res_nsend(res_state statp,
 	  const u_char *buf, int buflen, u_char *ans, int anssiz)
 {
-	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n;
+	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n, first_ns;
 	char abuf[NI_MAXHOST];
+#ifdef ANDROID_CHANGES
+	struct resolv_cache *cache;
+#endif
 
 	if (statp->nscount == 0) {
 		errno = ESRCH;
@@ -359,104 +380,71 @@ res_nsend(res_state statp,
 		errno = EINVAL;
 		return (-1);
 	}
+#ifdef ANDROID_CHANGES
+	cache = __get_res_cache();
+	if (cache != NULL) {
+		n = _resolv_cache_lookup_answer(cache, buf, buflen, ans, anssiz);
+		if (n >= 0)
+			return (n);
+	}
+#endif
 	DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
 		(stdout, ";; res_send()\n"), buf, buflen);
 	v_circuit = (statp->options & RES_USEVC) || buflen > PACKETSZ;
 	gotsomewhere = 0;
 	terrno = ETIMEDOUT;
+	first_ns = 0;
 
-	/*
-	 * If the ns_addr_list in the resolver context has changed, then
-	 * invalidate our cached copy and the associated timing data.
-	 */
-	if (EXT(statp).nscount != 0) {
-		int needclose = 0;
-		struct sockaddr_storage peer;
-		socklen_t peerlen;
-
-		if (EXT(statp).nscount != statp->nscount)
-			needclose++;
-		else
-			for (ns = 0; ns < statp->nscount; ns++) {
-				if (statp->nsaddr_list[ns].sin_family &&
-				    !sock_eq((struct sockaddr *)(void *)&statp->nsaddr_list[ns],
-					     (struct sockaddr *)(void *)&EXT(statp).ext->nsaddrs[ns])) {
-					needclose++;
-					break;
-				}
-
-				if (EXT(statp).nssocks[ns] == -1)
-					continue;
-				peerlen = sizeof(peer);
-				if (getsockname(EXT(statp).nssocks[ns],
-				    (struct sockaddr *)(void *)&peer, &peerlen) < 0) {
-					needclose++;
-					break;
-				}
-				if (!sock_eq((struct sockaddr *)(void *)&peer,
-				    get_nsaddr(statp, (size_t)ns))) {
-					needclose++;
-					break;
-				}
-			}
-		if (needclose) {
-			res_nclose(statp);
-			EXT(statp).nscount = 0;
-		}
-	}
+	sync_nsaddrs(statp);
 
 	/*
-	 * Maybe initialize our private copy of the ns_addr_list.
+	 * RES_BLAST: query all the servers over UDP, staggered by their
+	 * response times, and take the first answer.  A truncated answer
+	 * falls through to TCP below, starting with the server that sent it.
 	 */
-	if (EXT(statp).nscount == 0) {
-		for (ns = 0; ns < statp->nscount; ns++) {
-			EXT(statp).nstimes[ns] = RES_MAXTIME;
-			EXT(statp).nssocks[ns] = -1;
-			if (!statp->nsaddr_list[ns].sin_family)
+	if ((statp->options & RES_BLAST) != 0U && !v_circuit &&
+	    statp->qhook == NULL && statp->rhook == NULL) {
+		for (try = 0; try < statp->retry; try++) {
+			n = send_dg_blast(statp, buf, buflen, ans, anssiz,
+					  &terrno, &ns, &v_circuit,
+					  &gotsomewhere);
+			if (n < 0)
+				goto fail;
+			if (v_circuit) {
+				first_ns = ns;
+				break;
+			}
+			if (n == 0)
 				continue;
-			EXT(statp).ext->nsaddrs[ns].sin =
-				 statp->nsaddr_list[ns];
+			resplen = n;
+			statp->_flags &= ~RES_F_LASTMASK;
+			statp->_flags |= (ns << RES_F_LASTSHIFT);
+			DprintQ((statp->options & RES_DEBUG) ||
+				(statp->pfcode & RES_PRF_REPLY),
+				(stdout, ";; got answer:\n"),
+				ans, (resplen > anssiz) ? anssiz : resplen);
+			/* the datagram sockets are kept open on purpose */
+#ifdef ANDROID_CHANGES
+			if (cache != NULL && resplen <= anssiz)
+				_resolv_cache_add_answer(cache, buf, buflen,
+							 ans, resplen);
+#endif
+			return (resplen);
 		}
-		EXT(statp).nscount = statp->nscount;
-	}
-
-	/*
-	 * Some resolvers want to even out the load on their nameservers.
-	 * Note that RES_BLAST overrides RES_ROTATE.
-	 */
-	if ((statp->options & RES_ROTATE) != 0U &&
-	    (statp->options & RES_BLAST) == 0U) {
-		union res_sockaddr_union inu;
-		struct sockaddr_in ina;
-		int lastns = statp->nscount - 1;
-		int fd;
-		u_int16_t nstime;
-
-		if (EXT(statp).ext != NULL)
-			inu = EXT(statp).ext->nsaddrs[0];
-		ina = statp->nsaddr_list[0];
-		fd = EXT(statp).nssocks[0];
-		nstime = EXT(statp).nstimes[0];
-		for (ns = 0; ns < lastns; ns++) {
-			if (EXT(statp).ext != NULL)
-                                EXT(statp).ext->nsaddrs[ns] =
-					EXT(statp).ext->nsaddrs[ns + 1];
-			statp->nsaddr_list[ns] = statp->nsaddr_list[ns + 1];
-			EXT(statp).nssocks[ns] = EXT(statp).nssocks[ns + 1];
-			EXT(statp).nstimes[ns] = EXT(statp).nstimes[ns + 1];
+		if (!v_circuit) {
+			if (!gotsomewhere)
+				errno = ECONNREFUSED;
+			else
+				errno = ETIMEDOUT;
+			return (-1);
 		}
-		if (EXT(statp).ext != NULL)
-			EXT(statp).ext->nsaddrs[lastns] = inu;
-		statp->nsaddr_list[lastns] = ina;
-		EXT(statp).nssocks[lastns] = fd;
-		EXT(statp).nstimes[lastns] = nstime;
 	}
 
 	/*
 	 * Send request, RETRY times, or until successful.
 	 */
 	for (try = 0; try < statp->retry; try++) {
-	    for (ns = 0; ns < statp->nscount; ns++) {
+	    for (ns = first_ns; ns < statp->nscount; ns++) {
 		struct sockaddr *nsap;
 		int nsaplen;
 		nsap = get_nsaddr(statp, (size_t)ns);
@@ -513,7 +501,8 @@ res_nsend(res_state statp,
 			resplen = n;
 		} else {
 			/* Use datagrams. */
-			n = send_dg(statp, buf, buflen, ans, anssiz, &terrno,
+			n = send_dg(statp, buf, buflen, ans, anssiz,
+				    NULL, 0, NULL, 0, NULL, &terrno,
 				    ns, &v_circuit, &gotsomewhere);
 			if (n < 0)
 				goto fail;
@@ -572,9 +561,15 @@ res_nsend(res_state statp,
 			} while (!done);
 
 		}
+#ifdef ANDROID_CHANGES
+		if (cache != NULL && resplen <= anssiz)
+			_resolv_cache_add_answer(cache, buf, buflen, ans,
+						 resplen);
+#endif
 		return (resplen);
  next_ns: ;
 	   } /*foreach ns*/
+	   first_ns = 0;
 	} /*foreach retry*/
 	res_nclose(statp);
 	if (!v_circuit) {
@@ -590,8 +585,239 @@ res_nsend(res_state statp,
 	return (-1);
 }
 
+/*
+ * Like res_nsend(), but for two independent queries, typically the A and
+ * AAAA questions of an AF_UNSPEC lookup.  Both go out back to back on the
+ * same socket and the answers are collected by a single wait, so the
+ * lookup costs one round trip instead of two.  Anything that can't be
+ * done that way (TCP, truncated answers, hooks) falls back to sending the
+ * queries one after the other through res_nsend().
+ *
+ * The two queries must have different IDs.
+ */
+int
+res_nsend2(res_state statp,
+	   const u_char *buf, int buflen, u_char *ans, int anssiz,
+	   const u_char *buf2, int buflen2, u_char *ans2, int anssiz2,
+	   int *resplen2)
+{
+	int gotsomewhere, terrno, try, v_circuit, resplen, ns, n, saved;
+#ifdef ANDROID_CHANGES
+	struct resolv_cache *cache;
+#endif
+
+	*resplen2 = -1;
+	if (statp->nscount == 0) {
+		errno = ESRCH;
+		return (-1);
+	}
+	if (anssiz < HFIXEDSZ || anssiz2 < HFIXEDSZ) {
+		errno = EINVAL;
+		return (-1);
+	}
+	if ((statp->options & RES_USEVC) != 0U ||
+	    buflen > PACKETSZ || buflen2 > PACKETSZ ||
+	    statp->qhook != NULL || statp->rhook != NULL)
+		goto sequential;
+#ifdef ANDROID_CHANGES
+	cache = __get_res_cache();
+	if (cache != NULL) {
+		/* if either answer is cached, only the other one is sent */
+		resplen = _resolv_cache_lookup_answer(cache, buf, buflen,
+						      ans, anssiz);
+		n = _resolv_cache_lookup_answer(cache, buf2, buflen2,
+						ans2, anssiz2);
+		if (resplen >= 0 && n >= 0) {
+			*resplen2 = n;
+			return (resplen);
+		}
+		if (resplen >= 0) {
+			*resplen2 = res_nsend(statp, buf2, buflen2,
+					      ans2, anssiz2);
+			return (resplen);
+		}
+		if (n >= 0) {
+			*resplen2 = n;
+			return (res_nsend(statp, buf, buflen, ans, anssiz));
+		}
+	}
+#endif
+	DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
+		(stdout, ";; res_send2()\n"), buf, buflen);
+	DprintQ((statp->options & RES_DEBUG) || (statp->pfcode & RES_PRF_QUERY),
+		(stdout, "%s", ""), buf2, buflen2);
+	v_circuit = 0;
+	gotsomewhere = 0;
+	terrno = ETIMEDOUT;
+
+	sync_nsaddrs(statp);
+
+	for (try = 0; try < statp->retry; try++) {
+	    for (ns = 0; ns < statp->nscount; ns++) {
+		statp->_flags &= ~RES_F_LASTMASK;
+		statp->_flags |= (ns << RES_F_LASTSHIFT);
+
+		n = send_dg(statp, buf, buflen, ans, anssiz,
+			    buf2, buflen2, ans2, anssiz2, resplen2,
+			    &terrno, ns, &v_circuit, &gotsomewhere);
+		if (n < 0) {
+			res_nclose(statp);
+			return (-1);
+		}
+		if (v_circuit) {
+			/* an answer was truncated, let res_nsend() use TCP */
+			res_nclose(statp);
+			goto sequential;
+		}
+		if (n == 0 && *resplen2 < 0)
+			continue;
+		resplen = n;
+
+		Dprint((statp->options & RES_DEBUG) ||
+		       ((statp->pfcode & RES_PRF_REPLY) &&
+			(statp->pfcode & RES_PRF_HEAD1)),
+		       (stdout, ";; got answers:\n"));
+
+		if ((statp->options & RES_STAYOPEN) == 0U)
+			res_nclose(statp);
+#ifdef ANDROID_CHANGES
+		if (cache != NULL) {
+			if (resplen > 0 && resplen <= anssiz)
+				_resolv_cache_add_answer(cache, buf, buflen,
+							 ans, resplen);
+			if (*resplen2 > 0 && *resplen2 <= anssiz2)
+				_resolv_cache_add_answer(cache, buf2, buflen2,
+							 ans2, *resplen2);
+		}
+#endif
+		/*
+		 * Only one of the answers came: this server may just be
+		 * slow or picky about one of the types, so the missing
+		 * query gets the full res_nsend() treatment on its own.
+		 */
+		if (resplen == 0)
+			resplen = res_nsend(statp, buf, buflen, ans, anssiz);
+		else if (*resplen2 < 0) {
+			saved = errno;
+			*resplen2 = res_nsend(statp, buf2, buflen2,
+					      ans2, anssiz2);
+			errno = saved;
+		}
+		return (resplen);
+	   } /*foreach ns*/
+	} /*foreach retry*/
+	res_nclose(statp);
+	*resplen2 = -1;
+	if (!gotsomewhere)
+		errno = ECONNREFUSED;	/* no nameservers found */
+	else
+		errno = ETIMEDOUT;	/* no answer obtained */
+	return (-1);
+
+ sequential:
+	resplen = res_nsend(statp, buf, buflen, ans, anssiz);
+	saved = errno;
+	*resplen2 = res_nsend(statp, buf2, buflen2, ans2, anssiz2);
+	errno = saved;
+	return (resplen);
+}
+
 /* Private */
 
+/*
+ * If the ns_addr_list in the resolver context has changed, then
+ * invalidate our cached copy and the associated timing data.  Also
+ * rotates the list if asked to.
+ */
+static void
+sync_nsaddrs(res_state statp)
+{
+	int ns;
+
+	if (EXT(statp).nscount != 0) {
+		int needclose = 0;
+		struct sockaddr_storage peer;
+		socklen_t peerlen;
+
+		if (EXT(statp).nscount != statp->nscount)
+			needclose++;
+		else
+			for (ns = 0; ns < statp->nscount; ns++) {
+				if (statp->nsaddr_list[ns].sin_family &&
+				    !sock_eq((struct sockaddr *)(void *)&statp->nsaddr_list[ns],
+					     (struct sockaddr *)(void *)&EXT(statp).ext->nsaddrs[ns])) {
+					needclose++;
+					break;
+				}
+
+				if (EXT(statp).nssocks[ns] == -1)
+					continue;
+				peerlen = sizeof(peer);
+				if (getsockname(EXT(statp).nssocks[ns],
+				    (struct sockaddr *)(void *)&peer, &peerlen) < 0) {
+					needclose++;
+					break;
+				}
+				if (!sock_eq((struct sockaddr *)(void *)&peer,
+				    get_nsaddr(statp, (size_t)ns))) {
+					needclose++;
+					break;
+				}
+			}
+		if (needclose) {
+			res_nclose(statp);
+			EXT(statp).nscount = 0;
+		}
+	}
+
+	/*
+	 * Maybe initialize our private copy of the ns_addr_list.
+	 */
+	if (EXT(statp).nscount == 0) {
+		for (ns = 0; ns < statp->nscount; ns++) {
+			EXT(statp).nstimes[ns] = RES_MAXTIME;
+			EXT(statp).nssocks[ns] = -1;
+			if (!statp->nsaddr_list[ns].sin_family)
+				continue;
+			EXT(statp).ext->nsaddrs[ns].sin =
+				 statp->nsaddr_list[ns];
+		}
+		EXT(statp).nscount = statp->nscount;
+	}
+
+	/*
+	 * Some resolvers want to even out the load on their nameservers.
+	 * Note that RES_BLAST overrides RES_ROTATE.
+	 */
+	if ((statp->options & RES_ROTATE) != 0U &&
+	    (statp->options & RES_BLAST) == 0U) {
+		union res_sockaddr_union inu;
+		struct sockaddr_in ina;
+		int lastns = statp->nscount - 1;
+		int fd;
+		u_int16_t nstime;
+
+		if (EXT(statp).ext != NULL)
+			inu = EXT(statp).ext->nsaddrs[0];
+		ina = statp->nsaddr_list[0];
+		fd = EXT(statp).nssocks[0];
+		nstime = EXT(statp).nstimes[0];
+		for (ns = 0; ns < lastns; ns++) {
+			if (EXT(statp).ext != NULL)
+                                EXT(statp).ext->nsaddrs[ns] =
+					EXT(statp).ext->nsaddrs[ns + 1];
+			statp->nsaddr_list[ns] = statp->nsaddr_list[ns + 1];
+			EXT(statp).nssocks[ns] = EXT(statp).nssocks[ns + 1];
+			EXT(statp).nstimes[ns] = EXT(statp).nstimes[ns + 1];
+		}
+		if (EXT(statp).ext != NULL)
+			EXT(statp).ext->nsaddrs[lastns] = inu;
+		statp->nsaddr_list[lastns] = ina;
+		EXT(statp).nssocks[lastns] = fd;
+		EXT(statp).nstimes[lastns] = nstime;
+	}
+}
+
 static int
 get_salen(sa)
 	const struct sockaddr *sa;
@@ -828,132 +1054,91 @@ send_vc(res_state statp,
 	return (resplen);
 }
 
+/*
+ * Make sure there is an open datagram socket to server 'ns'.  Returns 1
+ * if there is, 0 if this server can't be used, and -1 on fatal errors.
+ */
 static int
-send_dg(res_state statp,
-	const u_char *buf, int buflen, u_char *ans, int anssiz,
-	int *terrno, int ns, int *v_circuit, int *gotsomewhere)
+open_dg_socket(res_state statp, int ns, int *terrno)
 {
-	const HEADER *hp = (const HEADER *)(const void *)buf;
-	HEADER *anhp = (HEADER *)(void *)ans;
 	const struct sockaddr *nsap;
 	int nsaplen;
-	struct timespec now, timeout, finish;
-	fd_set dsmask;
-	struct sockaddr_storage from;
-	socklen_t fromlen;
-	int resplen, seconds, n, s;
+
+	if (EXT(statp).nssocks[ns] != -1)
+		return (1);
 
 	nsap = get_nsaddr(statp, (size_t)ns);
 	nsaplen = get_salen(nsap);
-	if (EXT(statp).nssocks[ns] == -1) {
-		EXT(statp).nssocks[ns] = socket(nsap->sa_family, SOCK_DGRAM, 0);
-		if (EXT(statp).nssocks[ns] > highestFD) {
-			res_nclose(statp);
-			errno = ENOTSOCK;
-		}
-		if (EXT(statp).nssocks[ns] < 0) {
-			switch (errno) {
-			case EPROTONOSUPPORT:
+	EXT(statp).nssocks[ns] = socket(nsap->sa_family, SOCK_DGRAM, 0);
+	if (EXT(statp).nssocks[ns] > highestFD) {
+		res_nclose(statp);
+		errno = ENOTSOCK;
+	}
+	if (EXT(statp).nssocks[ns] < 0) {
+		switch (errno) {
+		case EPROTONOSUPPORT:
 #ifdef EPFNOSUPPORT
-			case EPFNOSUPPORT:
+		case EPFNOSUPPORT:
 #endif
-			case EAFNOSUPPORT:
-				Perror(statp, stderr, "socket(dg)", errno);
-				return (0);
-			default:
-				*terrno = errno;
-				Perror(statp, stderr, "socket(dg)", errno);
-				return (-1);
-			}
-		}
-#ifndef CANNOT_CONNECT_DGRAM
-		/*
-		 * On a 4.3BSD+ machine (client and server,
-		 * actually), sending to a nameserver datagram
-		 * port with no nameserver will cause an
-		 * ICMP port unreachable message to be returned.
-		 * If our datagram socket is "connected" to the
-		 * server, we get an ECONNREFUSED error on the next
-		 * socket operation, and select returns if the
-		 * error message is received.  We can thus detect
-		 * the absence of a nameserver without timing out.
-		 */
-		if (random_bind(EXT(statp).nssocks[ns], nsap->sa_family) < 0) {
-			Aerror(statp, stderr, "bind(dg)", errno, nsap,
-			    nsaplen);
-			res_nclose(statp);
-			return (0);
-		}
-		if (connect(EXT(statp).nssocks[ns], nsap, (socklen_t)nsaplen) < 0) {
-			Aerror(statp, stderr, "connect(dg)", errno, nsap,
-			    nsaplen);
-			res_nclose(statp);
+		case EAFNOSUPPORT:
+			Perror(statp, stderr, "socket(dg)", errno);
 			return (0);
+		default:
+			*terrno = errno;
+			Perror(statp, stderr, "socket(dg)", errno);
+			return (-1);
 		}
-#endif /* !CANNOT_CONNECT_DGRAM */
-		Dprint(statp->options & RES_DEBUG,
-		       (stdout, ";; new DG socket\n"))
 	}
-	s = EXT(statp).nssocks[ns];
 #ifndef CANNOT_CONNECT_DGRAM
-	if (send(s, (const char*)buf, (size_t)buflen, 0) != buflen) {
-		Perror(statp, stderr, "send", errno);
-		res_nclose(statp);
-		return (0);
-	}
-#else /* !CANNOT_CONNECT_DGRAM */
-	if (sendto(s, (const char*)buf, buflen, 0, nsap, nsaplen) != buflen)
-	{
-		Aerror(statp, stderr, "sendto", errno, nsap, nsaplen);
-		res_nclose(statp);
-		return (0);
-	}
-#endif /* !CANNOT_CONNECT_DGRAM */
-
 	/*
-	 * Wait for reply.
+	 * On a 4.3BSD+ machine (client and server,
+	 * actually), sending to a nameserver datagram
+	 * port with no nameserver will cause an
+	 * ICMP port unreachable message to be returned.
+	 * If our datagram socket is "connected" to the
+	 * server, we get an ECONNREFUSED error on the next
+	 * socket operation, and select returns if the
+	 * error message is received.  We can thus detect
+	 * the absence of a nameserver without timing out.
 	 */
-	seconds = (statp->retrans << ns);
-	if (ns > 0)
-		seconds /= statp->nscount;
-	if (seconds <= 0)
-		seconds = 1;
-	now = evNowTime();
-	timeout = evConsTime((long)seconds, 0L);
-	finish = evAddTime(now, timeout);
-	goto nonow;
- wait:
-	now = evNowTime();
- nonow:
-	FD_ZERO(&dsmask);
-	FD_SET(s, &dsmask);
-	if (evCmpTime(finish, now) > 0)
-		timeout = evSubTime(finish, now);
-	else
-		timeout = evConsTime(0L, 0L);
-	n = pselect(s + 1, &dsmask, NULL, NULL, &timeout, NULL);
-	if (n == 0) {
-		Dprint(statp->options & RES_DEBUG, (stdout, ";; timeout\n"));
-		*gotsomewhere = 1;
+	if (random_bind(EXT(statp).nssocks[ns], nsap->sa_family) < 0) {
+		Aerror(statp, stderr, "bind(dg)", errno, nsap,
+		    nsaplen);
+		close_dg_socket(statp, ns);
 		return (0);
 	}
-	if (n < 0) {
-		if (errno == EINTR)
-			goto wait;
-		Perror(statp, stderr, "select", errno);
-		res_nclose(statp);
+	if (connect(EXT(statp).nssocks[ns], nsap, (socklen_t)nsaplen) < 0) {
+		Aerror(statp, stderr, "connect(dg)", errno, nsap,
+		    nsaplen);
+		close_dg_socket(statp, ns);
 		return (0);
 	}
-	errno = 0;
-	fromlen = sizeof(from);
-	resplen = recvfrom(s, (char*)ans, (size_t)anssiz,0,
-			   (struct sockaddr *)(void *)&from, &fromlen);
-	if (resplen <= 0) {
-		Perror(statp, stderr, "recvfrom", errno);
-		res_nclose(statp);
-		return (0);
+#endif /* !CANNOT_CONNECT_DGRAM */
+	Dprint(statp->options & RES_DEBUG,
+	       (stdout, ";; new DG socket\n"))
+	return (1);
+}
+
+static void
+close_dg_socket(res_state statp, int ns)
+{
+	if (EXT(statp).nssocks[ns] != -1) {
+		(void) close(EXT(statp).nssocks[ns]);
+		EXT(statp).nssocks[ns] = -1;
 	}
-	*gotsomewhere = 1;
+}
+
+/*
+ * Check a datagram received in response to the query in 'buf'.
+ */
+static int
+check_dg_answer(res_state statp, const u_char *buf, int buflen,
+		u_char *ans, int anssiz, int resplen,
+		struct sockaddr *from, int *terrno)
+{
+	const HEADER *hp = (const HEADER *)(const void *)buf;
+	HEADER *anhp = (HEADER *)(void *)ans;
+
 	if (resplen < HFIXEDSZ) {
 		/*
 		 * Undersized message.
@@ -962,8 +1147,7 @@ send_dg(res_state statp,
 		       (stdout, ";; undersized: %d\n",
 			resplen));
 		*terrno = EMSGSIZE;
-		res_nclose(statp);
-		return (0);
+		return (DG_REJECT);
 	}
 	if (hp->id != anhp->id) {
 		/*
@@ -975,10 +1159,10 @@ send_dg(res_state statp,
 			(statp->pfcode & RES_PRF_REPLY),
 			(stdout, ";; old answer:\n"),
 			ans, (resplen > anssiz) ? anssiz : resplen);
-		goto wait;
+		return (DG_IGNORE);
 	}
 	if (!(statp->options & RES_INSECURE1) &&
-	    !res_ourserver_p(statp, (struct sockaddr *)(void *)&from)) {
+	    !res_ourserver_p(statp, from)) {
 		/*
 		 * response from wrong server? ignore it.
 		 * XXX - potential security hazard could
@@ -988,7 +1172,7 @@ send_dg(res_state statp,
 			(statp->pfcode & RES_PRF_REPLY),
 			(stdout, ";; not our server:\n"),
 			ans, (resplen > anssiz) ? anssiz : resplen);
-		goto wait;
+		return (DG_IGNORE);
 	}
 #ifdef RES_USE_EDNS0
 	if (anhp->rcode == FORMERR && (statp->options & RES_USE_EDNS0) != 0U) {
@@ -1002,8 +1186,7 @@ send_dg(res_state statp,
 			ans, (resplen > anssiz) ? anssiz : resplen);
 		/* record the error */
 		statp->_flags |= RES_F_EDNS0ERR;
-		res_nclose(statp);
-		return (0);
+		return (DG_REJECT);
 	}
 #endif
 	if (!(statp->options & RES_INSECURE2) &&
@@ -1018,7 +1201,7 @@ send_dg(res_state statp,
 			(statp->pfcode & RES_PRF_REPLY),
 			(stdout, ";; wrong query name:\n"),
 			ans, (resplen > anssiz) ? anssiz : resplen);
-		goto wait;
+		return (DG_IGNORE);
 	}
 	if (anhp->rcode == SERVFAIL ||
 	    anhp->rcode == NOTIMP ||
@@ -1026,27 +1209,377 @@ send_dg(res_state statp,
 		DprintQ(statp->options & RES_DEBUG,
 			(stdout, "server rejected query:\n"),
 			ans, (resplen > anssiz) ? anssiz : resplen);
-		res_nclose(statp);
 		/* don't retry if called from dig */
 		if (!statp->pfcode)
-			return (0);
+			return (DG_REJECT);
 	}
 	if (!(statp->options & RES_IGNTC) && anhp->tc) {
+		Dprint(statp->options & RES_DEBUG,
+		       (stdout, ";; truncated answer\n"));
+		return (DG_TRUNCATED);
+	}
+	return (DG_ACCEPT);
+}
+
+/*
+ * When buf2 is not NULL, a second query is sent right after the first one
+ * and both answers are waited for.  The length of the first answer is
+ * returned and the length of the second one is stored in *resplen2, or
+ * -1 if it didn't come.  If only the second one came, 0 is returned, so
+ * the caller must look at *resplen2 before moving to the next server.
+ */
+static int
+send_dg(res_state statp,
+	const u_char *buf, int buflen, u_char *ans, int anssiz,
+	const u_char *buf2, int buflen2, u_char *ans2, int anssiz2,
+	int *resplen2, int *terrno, int ns, int *v_circuit, int *gotsomewhere)
+{
+	const u_char *qbuf;
+	u_char *rbuf;
+	int qbuflen, rbufsiz;
+	const struct sockaddr *nsap;
+	int nsaplen;
+	struct timespec now, timeout, finish;
+	fd_set dsmask;
+	struct sockaddr_storage from;
+	socklen_t fromlen;
+	int resplen, seconds, n, s;
+	int anslen1 = -1, anslen2 = -1;
+
+	nsap = get_nsaddr(statp, (size_t)ns);
+	nsaplen = get_salen(nsap);
+	n = open_dg_socket(statp, ns, terrno);
+	if (n <= 0)
+		return (n);
+	s = EXT(statp).nssocks[ns];
+#ifndef CANNOT_CONNECT_DGRAM
+	if (send(s, (const char*)buf, (size_t)buflen, 0) != buflen ||
+	    (buf2 != NULL &&
+	     send(s, (const char*)buf2, (size_t)buflen2, 0) != buflen2)) {
+		Perror(statp, stderr, "send", errno);
+		res_nclose(statp);
+		return (0);
+	}
+#else /* !CANNOT_CONNECT_DGRAM */
+	if (sendto(s, (const char*)buf, buflen, 0, nsap, nsaplen) != buflen ||
+	    (buf2 != NULL &&
+	     sendto(s, (const char*)buf2, buflen2, 0, nsap, nsaplen) != buflen2))
+	{
+		Aerror(statp, stderr, "sendto", errno, nsap, nsaplen);
+		res_nclose(statp);
+		return (0);
+	}
+#endif /* !CANNOT_CONNECT_DGRAM */
+
+	/*
+	 * Wait for reply.
+	 */
+	seconds = (statp->retrans << ns);
+	if (ns > 0)
+		seconds /= statp->nscount;
+	if (seconds <= 0)
+		seconds = 1;
+	now = evNowTime();
+	timeout = evConsTime((long)seconds, 0L);
+	finish = evAddTime(now, timeout);
+	goto nonow;
+ wait:
+	now = evNowTime();
+ nonow:
+	FD_ZERO(&dsmask);
+	FD_SET(s, &dsmask);
+	if (evCmpTime(finish, now) > 0)
+		timeout = evSubTime(finish, now);
+	else
+		timeout = evConsTime(0L, 0L);
+	n = pselect(s + 1, &dsmask, NULL, NULL, &timeout, NULL);
+	if (n == 0) {
+		Dprint(statp->options & RES_DEBUG, (stdout, ";; timeout\n"));
+		*gotsomewhere = 1;
+		if (buf2 != NULL)
+			goto settled;
+		return (0);
+	}
+	if (n < 0) {
+		if (errno == EINTR)
+			goto wait;
+		Perror(statp, stderr, "select", errno);
+		res_nclose(statp);
+		return (0);
+	}
+	/*
+	 * With two queries in flight, peek at the ID of the reply to find
+	 * out which one it answers.  Anything that matches neither goes to
+	 * a buffer that is still free and gets rejected below.  An answer
+	 * length of -1 means still waiting, 0 means the server refused it.
+	 */
+	qbuf = buf;
+	qbuflen = buflen;
+	rbuf = ans;
+	rbufsiz = anssiz;
+	if (buf2 != NULL) {
+		u_int16_t id;
+
+		if (recv(s, (char*)&id, sizeof(id), MSG_PEEK) == sizeof(id) &&
+		    anslen2 < 0 &&
+		    (anslen1 >= 0 ||
+		     id == ((const HEADER *)(const void *)buf2)->id)) {
+			qbuf = buf2;
+			qbuflen = buflen2;
+			rbuf = ans2;
+			rbufsiz = anssiz2;
+		}
+	}
+	errno = 0;
+	fromlen = sizeof(from);
+	resplen = recvfrom(s, (char*)rbuf, (size_t)rbufsiz,0,
+			   (struct sockaddr *)(void *)&from, &fromlen);
+	if (resplen <= 0) {
+		Perror(statp, stderr, "recvfrom", errno);
+		res_nclose(statp);
+		if (buf2 != NULL)
+			goto settled;
+		return (0);
+	}
+	*gotsomewhere = 1;
+	switch (check_dg_answer(statp, qbuf, qbuflen, rbuf, rbufsiz, resplen,
+				(struct sockaddr *)(void *)&from, terrno)) {
+	case DG_IGNORE:
+		goto wait;
+	case DG_REJECT:
+		if (buf2 != NULL) {
+			/* the other answer may still be good */
+			if (qbuf == buf)
+				anslen1 = 0;
+			else
+				anslen2 = 0;
+			if (anslen1 < 0 || anslen2 < 0)
+				goto wait;
+			res_nclose(statp);
+			goto settled;
+		}
+		res_nclose(statp);
+		return (0);
+	case DG_TRUNCATED:
 		/*
 		 * To get the rest of answer,
 		 * use TCP with same server.
 		 */
-		Dprint(statp->options & RES_DEBUG,
-		       (stdout, ";; truncated answer\n"));
 		*v_circuit = 1;
 		res_nclose(statp);
 		return (1);
 	}
+	if (buf2 != NULL) {
+		if (qbuf == buf)
+			anslen1 = resplen;
+		else
+			anslen2 = resplen;
+		if (anslen1 < 0 || anslen2 < 0)
+			goto wait;
+		goto settled;
+	}
 	/*
 	 * All is well, or the error is fatal.  Signal that the
 	 * next nameserver ought not be tried.
 	 */
 	return (resplen);
+
+ settled:
+	/* hand back whichever answers did come */
+	*resplen2 = anslen2 > 0 ? anslen2 : -1;
+	return (anslen1 > 0 ? anslen1 : 0);
+}
+
+/*
+ * Record a response time for server 'ns', as a moving average.  Servers
+ * that failed to answer are set to RES_DEADTIME, and start over from
+ * their next answer.
+ */
+static void
+update_nstime(res_state statp, int ns, struct timespec rtt)
+{
+	long ms = rtt.tv_sec * 1000L + rtt.tv_nsec / 1000000L;
+	u_int16_t *nstime = &EXT(statp).nstimes[ns];
+
+	if (ms >= RES_DEADTIME)
+		ms = RES_DEADTIME - 1;
+	if (*nstime >= RES_DEADTIME)
+		*nstime = (u_int16_t)ms;
+	else
+		*nstime = (u_int16_t)((3 * (long)*nstime + ms) / 4);
+}
+
+/*
+ * Sort key for send_dg_blast(): servers with a known response time come
+ * first, then the ones never tried, then the ones that failed last time.
+ */
+static long
+nstime_rank(u_int16_t nstime)
+{
+	if (nstime == RES_DEADTIME)
+		return (RES_MAXTIME + 1L);
+	return (nstime);
+}
+
+/*
+ * RES_BLAST transport: the query is first sent to the server with the
+ * best recent response time.  If it doesn't answer within twice that
+ * time, or fails, the next server is started, and so on, while still
+ * listening to all of them.  The first valid answer wins.
+ *
+ * The sockets are the per-server ones from the resolver state and are
+ * kept open between queries.  On success, *nsp is the server that
+ * answered.  Returns like send_dg().
+ */
+static int
+send_dg_blast(res_state statp, const u_char *buf, int buflen,
+	      u_char *ans, int anssiz, int *terrno, int *nsp,
+	      int *v_circuit, int *gotsomewhere)
+{
+	struct pollfd pfds[MAXNS];
+	int pfdns[MAXNS];
+	int order[MAXNS];
+	struct timespec sent[MAXNS];
+	struct timespec now, finish, start_next, timeout;
+	struct sockaddr_storage from;
+	socklen_t fromlen;
+	int nscount = statp->nscount;
+	int i, j, n, ns, next, npending, resplen, seconds, stagger;
+
+	/* fastest servers first; ties keep their configured order */
+	for (i = 0; i < nscount; i++) {
+		for (j = i; j > 0 &&
+		     nstime_rank(EXT(statp).nstimes[order[j - 1]]) >
+		     nstime_rank(EXT(statp).nstimes[i]);
+		     j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+
+	seconds = statp->retrans;
+	if (seconds <= 0)
+		seconds = 1;
+	now = evNowTime();
+	finish = evAddTime(now, evConsTime((long)seconds, 0L));
+	start_next = now;
+	next = 0;
+	npending = 0;
+
+	for (;;) {
+		/*
+		 * Start the next server if the previous ones are late, or
+		 * all failed.
+		 */
+		while (next < nscount && evCmpTime(now, start_next) >= 0) {
+			ns = order[next++];
+			n = open_dg_socket(statp, ns, terrno);
+			if (n < 0)
+				return (-1);
+			if (n == 0)
+				continue;
+#ifndef CANNOT_CONNECT_DGRAM
+			if (send(EXT(statp).nssocks[ns], (const char*)buf,
+				 (size_t)buflen, 0) != buflen) {
+				Perror(statp, stderr, "send", errno);
+				close_dg_socket(statp, ns);
+				continue;
+			}
+#else /* !CANNOT_CONNECT_DGRAM */
+			if (sendto(EXT(statp).nssocks[ns], (const char*)buf,
+				   buflen, 0, get_nsaddr(statp, (size_t)ns),
+				   get_salen(get_nsaddr(statp, (size_t)ns)))
+			    != buflen) {
+				Perror(statp, stderr, "sendto", errno);
+				close_dg_socket(statp, ns);
+				continue;
+			}
+#endif /* !CANNOT_CONNECT_DGRAM */
+			pfds[npending].fd = EXT(statp).nssocks[ns];
+			pfds[npending].events = POLLIN;
+			pfds[npending].revents = 0;
+			pfdns[npending] = ns;
+			npending++;
+			sent[ns] = now;
+
+			stagger = seconds * 1000 / nscount;
+			if (EXT(statp).nstimes[ns] < RES_DEADTIME &&
+			    2 * EXT(statp).nstimes[ns] + 10 < stagger)
+				stagger = 2 * EXT(statp).nstimes[ns] + 10;
+			start_next = evAddTime(now, evConsTime(stagger / 1000,
+			    (stagger % 1000) * 1000000L));
+		}
+
+		if (npending == 0) {
+			if (next < nscount)
+				continue;
+			return (0);	/* all servers failed */
+		}
+
+		if (evCmpTime(finish, now) <= 0) {
+			Dprint(statp->options & RES_DEBUG,
+			       (stdout, ";; timeout\n"));
+			for (i = 0; i < npending; i++)
+				EXT(statp).nstimes[pfdns[i]] = RES_DEADTIME;
+			*gotsomewhere = 1;
+			return (0);
+		}
+		if (next < nscount && evCmpTime(start_next, finish) < 0)
+			timeout = evSubTime(start_next, now);
+		else
+			timeout = evSubTime(finish, now);
+
+		n = poll(pfds, (nfds_t)npending,
+			 (int)(timeout.tv_sec * 1000 +
+			       (timeout.tv_nsec + 999999) / 1000000));
+		now = evNowTime();
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			Perror(statp, stderr, "poll", errno);
+			return (0);
+		}
+
+		for (i = 0; n > 0 && i < npending; i++) {
+			if (pfds[i].revents == 0)
+				continue;
+			n--;
+			ns = pfdns[i];
+			errno = 0;
+			fromlen = sizeof(from);
+			resplen = recvfrom(pfds[i].fd, (char*)ans,
+					   (size_t)anssiz, 0,
+					   (struct sockaddr *)(void *)&from,
+					   &fromlen);
+			if (resplen <= 0) {
+				/* typically ECONNREFUSED, nobody's there */
+				Perror(statp, stderr, "recvfrom", errno);
+				goto drop;
+			}
+			*gotsomewhere = 1;
+			switch (check_dg_answer(statp, buf, buflen, ans, anssiz,
+			    resplen, (struct sockaddr *)(void *)&from, terrno)) {
+			case DG_IGNORE:
+				continue;
+			case DG_REJECT:
+				goto drop;
+			case DG_TRUNCATED:
+				*nsp = ns;
+				*v_circuit = 1;
+				return (1);
+			}
+			update_nstime(statp, ns, evSubTime(now, sent[ns]));
+			*nsp = ns;
+			return (resplen);
+		drop:
+			/* stop waiting for this one, start the next one now */
+			EXT(statp).nstimes[ns] = RES_DEADTIME;
+			npending--;
+			pfds[i] = pfds[npending];
+			pfdns[i] = pfdns[npending];
+			i--;
+			start_next = now;
+		}
+	}
 }
 
 static void
@@ -52,6 +52,23 @@ extern void                  _resolv_cache_add( struct resolv_cache*  cache,
                                                 int                   af,
                                                 struct hostent*       hp );
 
+/* look up a cached DNS answer for the raw 'query' packet. on success, the answer
+ * is copied to 'answer' with the query's ID and its length is returned. returns
+ * -1 if there is no fresh answer that fits in 'answersize' bytes.
+ */
+extern int                   _resolv_cache_lookup_answer( struct resolv_cache*  cache,
+                                                          const void*           query,
+                                                          int                   querylen,
+                                                          void*                 answer,
+                                                          int                   answersize );
+
+/* cache the DNS 'answer' received for 'query', if its TTLs allow it */
+extern void                  _resolv_cache_add_answer( struct resolv_cache*  cache,
+                                                       const void*           query,
+                                                       int                   querylen,
+                                                       const void*           answer,
+                                                       int                   answerlen );
+
 extern struct hostent*       _resolv_hostent_copy( struct hostent*  hp );
 extern void                  _resolv_hostent_free( struct hostent*  hp );
 
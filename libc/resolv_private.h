@@ -135,6 +135,7 @@ struct res_sym {
 #define	RES_MAXRETRY		5	/* only for resolv.conf/RES_OPTIONS */
 #define	RES_DFLRETRY		2	/* Default #/tries. */
 #define	RES_MAXTIME		65535	/* Infinity, in milliseconds. */
+#define	RES_DEADTIME		65534	/* Server failed to answer. */
 
 struct __res_state_ext;
 
@@ -381,6 +382,7 @@ extern const struct res_sym __p_rcode_syms[];
 #define res_nquerydomain	__res_nquerydomain
 #define res_nsearch		__res_nsearch
 #define res_nsend		__res_nsend
+#define res_nsend2		__res_nsend2
 #define res_nsendsigned		__res_nsendsigned
 #define res_nisourserver	__res_nisourserver
 #define res_ownok		__res_ownok
@@ -464,6 +466,11 @@ int		res_nmkquery(res_state, int, const char *, int, int,
 				  const u_char *, int, const u_char *,
 				  u_char *, int);
 int		res_nsend(res_state, const u_char *, int, u_char *, int);
+/* sends two queries at once over UDP and waits for both answers, returns
+ * the length of the first one and stores the length of the second one (or
+ * -1) in the last argument. */
+int		res_nsend2(res_state, const u_char *, int, u_char *, int,
+				const u_char *, int, u_char *, int, int *);
 int		res_nsendsigned(res_state, const u_char *, int,
 				     ns_tsig_key *, u_char *, int);
 int		res_findzonecut(res_state, const char *, ns_class, int,
@@ -24,6 +24,7 @@ typedef struct res_static {
     int             stayopen;
     const char*     servent_ptr;
     struct servent  servent;
+    int             servent_size;   /* allocated size of servent.s_aliases */
     struct hostent  host;
 } *res_static;
 
@@ -33,6 +33,7 @@
 
 #include <stdio.h>
 #undef	clearerr
+#undef	clearerr_unlocked
 
 void
 clearerr(FILE *fp)
@@ -41,3 +42,9 @@ clearerr(FILE *fp)
 	__sclearerr(fp);
 	funlockfile(fp);
 }
+
+void
+clearerr_unlocked(FILE *fp)
+{
+	__sclearerr(fp);
+}
@@ -45,6 +45,7 @@ fclose(FILE *fp)
 		errno = EBADF;
 		return (EOF);
 	}
+	FLOCKFILE(fp);
 	WCIO_FREE(fp);
 	r = fp->_flags & __SWR ? __sflush(fp) : 0;
 	if (fp->_close != NULL && (*fp->_close)(fp->_cookie) < 0)
@@ -55,7 +56,12 @@ fclose(FILE *fp)
 		FREEUB(fp);
 	if (HASLB(fp))
 		FREELB(fp);
-	fp->_flags = 0;		/* Release this FILE for reuse. */
 	fp->_r = fp->_w = 0;	/* Mess up if reaccessed. */
+	/*
+	 * Release this FILE for reuse.  __sfp() doesn't reset the lock, so
+	 * a new user of this FILE waits for us to drop it.
+	 */
+	fp->_flags = 0;
+	FUNLOCKFILE(fp);
 	return (r);
 }
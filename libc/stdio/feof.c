@@ -43,3 +43,14 @@ feof(FILE *fp)
 {
 	return (__sfeof(fp));
 }
+
+/*
+ * A subroutine version of the macro feof_unlocked.
+ */
+#undef feof_unlocked
+
+int
+feof_unlocked(FILE *fp)
+{
+	return (__sfeof(fp));
+}
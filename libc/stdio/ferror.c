@@ -43,3 +43,14 @@ ferror(FILE *fp)
 {
 	return (__sferror(fp));
 }
+
+/*
+ * A subroutine version of the macro ferror_unlocked.
+ */
+#undef ferror_unlocked
+
+int
+ferror_unlocked(FILE *fp)
+{
+	return (__sferror(fp));
+}
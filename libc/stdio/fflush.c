@@ -35,9 +35,25 @@
 #include <stdio.h>
 #include "local.h"
 
-/* Flush a single file, or (if fp is NULL) all files.  */
+/*
+ * Flush a single file, or (if fp is NULL) all files.  When flushing all
+ * files, _fwalk() takes the lock of each one in turn.
+ */
 int
 fflush(FILE *fp)
+{
+	int ret;
+
+	if (fp == NULL)
+		return (_fwalk(__sflush));
+	FLOCKFILE(fp);
+	ret = fflush_unlocked(fp);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
+
+int
+fflush_unlocked(FILE *fp)
 {
 
 	if (fp == NULL)
@@ -32,9 +32,21 @@
  */
 
 #include <stdio.h>
+#include "local.h"
 
 int
 fgetc(FILE *fp)
+{
+	int c;
+
+	FLOCKFILE(fp);
+	c = __sgetc(fp);
+	FUNLOCKFILE(fp);
+	return (c);
+}
+
+int
+fgetc_unlocked(FILE *fp)
 {
 	return (__sgetc(fp));
 }
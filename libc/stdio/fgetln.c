@@ -67,8 +67,21 @@ __slbexpand(FILE *fp, size_t newsize)
  * not necessarily end with '\0'), but does allow callers to modify
  * it if they wish.  Thus, we set __SMOD in case the caller does.
  */
+static char *__sfgetln(FILE *, size_t *);
+
 char *
 fgetln(FILE *fp, size_t *lenp)
+{
+	char *ret;
+
+	FLOCKFILE(fp);
+	ret = __sfgetln(fp, lenp);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
+
+static char *
+__sfgetln(FILE *fp, size_t *lenp)
 {
 	unsigned char *p;
 	size_t len;
@@ -42,7 +42,7 @@
  * Do not return NULL if n == 1.
  */
 char *
-fgets(char *buf, int n, FILE *fp)
+fgets_unlocked(char *buf, int n, FILE *fp)
 {
 	size_t len;
 	char *s;
@@ -95,3 +95,14 @@ fgets(char *buf, int n, FILE *fp)
 	*s = '\0';
 	return (buf);
 }
+
+char *
+fgets(char *buf, int n, FILE *fp)
+{
+	char *ret;
+
+	FLOCKFILE(fp);
+	ret = fgets_unlocked(buf, n, fp);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
@@ -35,11 +35,26 @@
 struct __sfileext {
 	struct	__sbuf _ub; /* ungetc buffer */
 	struct wchar_io_data _wcio;	/* wide char io status */
+	volatile int _lock;	/* 0: free, 1: locked, 2: locked, contended */
+	pthread_t _lock_owner;	/* thread holding _lock, or 0 */
+	int	_lock_count;	/* recursive flockfile() calls by the owner */
 };
 
 #define _EXT(fp) ((struct __sfileext *)((fp)->_ext._base))
 #define _UB(fp) _EXT(fp)->_ub
 
+/*
+ * The lock is only set up along with the FILE itself: a FILE that is
+ * being recycled by __sfp() may still be locked by the thread that
+ * closed it.
+ */
+#define _FILEEXT_LOCK_INIT(fp) \
+do { \
+	_EXT(fp)->_lock = 0; \
+	_EXT(fp)->_lock_owner = 0; \
+	_EXT(fp)->_lock_count = 0; \
+} while (0)
+
 #define _FILEEXT_INIT(fp) \
 do { \
 	_UB(fp)._base = NULL; \
@@ -50,5 +65,6 @@ do { \
 #define _FILEEXT_SETUP(f, fext) \
 do { \
 	(f)->_ext._base = (unsigned char *)(fext); \
+	_FILEEXT_LOCK_INIT(f); \
 	_FILEEXT_INIT(f); \
 } while (0)
@@ -43,3 +43,14 @@ fileno(FILE *fp)
 {
 	return (__sfileno(fp));
 }
+
+/*
+ * A subroutine version of the macro fileno_unlocked.
+ */
+#undef fileno_unlocked
+
+int
+fileno_unlocked(FILE *fp)
+{
+	return (__sfileno(fp));
+}
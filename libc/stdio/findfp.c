@@ -39,9 +39,13 @@
 #include <string.h>
 #include "local.h"
 #include "glue.h"
+#include "thread_private.h"
 
 int	__sdidinit;
 
+/* protects the allocation of FILEs, but not the FILEs themselves */
+_THREAD_PRIVATE_MUTEX(__sfp_mutex);
+
 #define	NDYNAMIC 10		/* add ten more whenever necessary */
 
 #define	std(flags, file) \
@@ -104,6 +108,7 @@ __sfp(void)
 
 	if (!__sdidinit)
 		__sinit();
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
 	for (g = &__sglue;; g = g->next) {
 		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++)
 			if (fp->_flags == 0)
@@ -111,9 +116,11 @@ __sfp(void)
 		if (g->next == NULL && (g->next = moreglue(NDYNAMIC)) == NULL)
 			break;
 	}
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 	return (NULL);
 found:
 	fp->_flags = 1;		/* reserve this slot; caller sets real flags */
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 	fp->_p = NULL;		/* no current pointer */
 	fp->_w = 0;		/* nothing to read or write */
 	fp->_r = 0;
@@ -161,7 +168,11 @@ void
 _cleanup(void)
 {
 	/* (void) _fwalk(fclose); */
-	(void) _fwalk(__sflush);		/* `cheating' */
+	/*
+	 * Don't wait for the FILEs other threads are using: one of them
+	 * may be blocked reading from a terminal.
+	 */
+	(void) _fwalk_nowait(__sflush);		/* `cheating' */
 }
 
 /*
@@ -172,10 +183,15 @@ __sinit(void)
 {
 	int i;
 
+	_THREAD_PRIVATE_MUTEX_LOCK(__sfp_mutex);
+	if (__sdidinit)
+		goto out;	/* another thread got here first */
 	for (i = 0; i < FOPEN_MAX - 3; i++) {
 		_FILEEXT_SETUP(usual+i, usualext+i);
 	}
 	/* make sure we clean up on exit */
 	__atexit_register_cleanup(_cleanup); /* conservative */
 	__sdidinit = 1;
+out:
+	_THREAD_PRIVATE_MUTEX_UNLOCK(__sfp_mutex);
 }
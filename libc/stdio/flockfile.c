@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2008 The Android Open Source Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *  * Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  * Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Per-FILE locks, as required by POSIX for the stdio functions.
+ *
+ * The lock is a three-state futex word like the one used for normal
+ * pthread mutexes (see pthread.c), plus an owner and a recursion count
+ * since flockfile() nests.  Taking an uncontended lock costs a single
+ * atomic operation.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/atomics.h>
+#include "local.h"
+
+void
+flockfile(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+	pthread_t self = pthread_self();
+
+	/* only this thread can have stored itself as the owner */
+	if (ext->_lock_owner == self) {
+		ext->_lock_count++;
+		return;
+	}
+	if (__atomic_cmpxchg(0, 1, &ext->_lock) != 0) {
+		while (__atomic_swap(2, &ext->_lock) != 0)
+			__futex_wait(&ext->_lock, 2, 0);
+	}
+	ext->_lock_owner = self;
+}
+
+int
+ftrylockfile(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+	pthread_t self = pthread_self();
+
+	if (ext->_lock_owner == self) {
+		ext->_lock_count++;
+		return (0);
+	}
+	if (__atomic_cmpxchg(0, 1, &ext->_lock) != 0)
+		return (-1);
+	ext->_lock_owner = self;
+	return (0);
+}
+
+void
+funlockfile(FILE *fp)
+{
+	struct __sfileext *ext = _EXT(fp);
+
+	if (ext->_lock_owner != pthread_self()) {
+		/*
+		 * Unlocking a FILE this thread does not hold is a bug in the
+		 * caller.  Don't go through stdio to report it.
+		 */
+		static const char msg[] =
+		    "funlockfile: FILE not locked by the calling thread\n";
+		(void) write(STDERR_FILENO, msg, sizeof(msg) - 1);
+		abort();
+	}
+	if (ext->_lock_count > 0) {
+		ext->_lock_count--;
+		return;
+	}
+	ext->_lock_owner = 0;
+	if (__atomic_dec(&ext->_lock) != 1) {
+		/* someone is waiting, see _normal_unlock() in pthread.c */
+		ext->_lock = 0;
+		__futex_wake(&ext->_lock, 1);
+	}
+}
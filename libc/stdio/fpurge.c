@@ -48,11 +48,13 @@ fpurge(FILE *fp)
 		return(EOF);
 	}
 
+	FLOCKFILE(fp);
 	if (HASUB(fp))
 		FREEUB(fp);
 	WCIO_FREE(fp);
 	fp->_p = fp->_bf._base;
 	fp->_r = 0;
 	fp->_w = fp->_flags & (__SLBF|__SNBF) ? 0 : fp->_bf._size;
+	FUNLOCKFILE(fp);
 	return (0);
 }
@@ -36,11 +36,22 @@
 #include "local.h"
 
 int
-fputc(int c, FILE *fp)
+fputc_unlocked(int c, FILE *fp)
 {
 	if (cantwrite(fp)) {
 		errno = EBADF;
 		return (EOF);
 	}
-	return (putc(c, fp));
+	return (putc_unlocked(c, fp));
+}
+
+int
+fputc(int c, FILE *fp)
+{
+	int ret;
+
+	FLOCKFILE(fp);
+	ret = fputc_unlocked(c, fp);
+	FUNLOCKFILE(fp);
+	return (ret);
 }
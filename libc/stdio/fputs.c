@@ -40,7 +40,7 @@
  * Write the given string to the given file.
  */
 int
-fputs(const char *s, FILE *fp)
+fputs_unlocked(const char *s, FILE *fp)
 {
 	struct __suio uio;
 	struct __siov iov;
@@ -52,3 +52,14 @@ fputs(const char *s, FILE *fp)
 	_SET_ORIENTATION(fp, -1);
 	return (__sfvwrite(fp, &uio));
 }
+
+int
+fputs(const char *s, FILE *fp)
+{
+	int ret;
+
+	FLOCKFILE(fp);
+	ret = fputs_unlocked(s, fp);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
@@ -46,7 +46,7 @@ lflush(FILE *fp)
 }
 
 size_t
-fread(void *buf, size_t size, size_t count, FILE *fp)
+fread_unlocked(void *buf, size_t size, size_t count, FILE *fp)
 {
 	size_t resid;
 	char *p;
@@ -117,7 +117,7 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
         */
 
         if (fp->_flags & (__SLBF|__SNBF))
-            (void) _fwalk(lflush);
+            (void) _fwalk_nowait(lflush);
 
         while (resid > 0) {
             int   len = (*fp->_read)(fp->_cookie, p, resid );
@@ -156,3 +156,14 @@ fread(void *buf, size_t size, size_t count, FILE *fp)
 	fp->_p += resid;
 	return (count);
 }
+
+size_t
+fread(void *buf, size_t size, size_t count, FILE *fp)
+{
+	size_t ret;
+
+	FLOCKFILE(fp);
+	ret = fread_unlocked(buf, size, count, fp);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
@@ -41,12 +41,25 @@
 
 #define	POS_ERR	(-(fpos_t)1)
 
+static int __sfseeko(FILE *, off_t, int);
+
 /*
  * Seek the given file to the given offset.
  * `Whence' must be one of the three SEEK_* macros.
  */
 int
 fseeko(FILE *fp, off_t offset, int whence)
+{
+	int ret;
+
+	FLOCKFILE(fp);
+	ret = __sfseeko(fp, offset, whence);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
+
+static int
+__sfseeko(FILE *fp, off_t offset, int whence)
 {
 	fpos_t (*seekfn)(void *, fpos_t, int);
 	fpos_t target, curoff;
@@ -52,13 +52,16 @@ ftello(FILE *fp)
 	 * Find offset of underlying I/O object, then
 	 * adjust for buffered bytes.
 	 */
+	FLOCKFILE(fp);
 	__sflush(fp);		/* may adjust seek offset on append stream */
 	if (fp->_flags & __SOFF)
 		pos = fp->_offset;
 	else {
 		pos = (*fp->_seek)(fp->_cookie, (fpos_t)0, SEEK_CUR);
-		if (pos == -1L)
+		if (pos == -1L) {
+			FUNLOCKFILE(fp);
 			return (pos);
+		}
 	}
 	if (fp->_flags & __SRD) {
 		/*
@@ -77,6 +80,7 @@ ftello(FILE *fp)
 		 */
 		pos += fp->_p - fp->_bf._base;
 	}
+	FUNLOCKFILE(fp);
 	return (pos);
 }
 
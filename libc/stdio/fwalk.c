@@ -36,8 +36,14 @@
 #include "local.h"
 #include "glue.h"
 
-int
-_fwalk(int (*function)(FILE *))
+/*
+ * Call 'function' on each open FILE, holding that FILE's lock.  There is
+ * no global lock: the FILEs are never freed, and one that is opened or
+ * closed meanwhile is simply seen or not.  With 'nowait', the FILEs that
+ * another thread is using are skipped instead of waited for.
+ */
+static int
+__fwalk(int (*function)(FILE *), int nowait)
 {
 	FILE *fp;
 	int n, ret;
@@ -45,8 +51,29 @@ _fwalk(int (*function)(FILE *))
 
 	ret = 0;
 	for (g = &__sglue; g != NULL; g = g->next)
-		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++)
+		for (fp = g->iobs, n = g->niobs; --n >= 0; fp++) {
+			if (fp->_flags == 0)
+				continue;
+			if (nowait) {
+				if (ftrylockfile(fp) != 0)
+					continue;
+			} else
+				FLOCKFILE(fp);
 			if (fp->_flags != 0)
 				ret |= (*function)(fp);
+			FUNLOCKFILE(fp);
+		}
 	return (ret);
 }
+
+int
+_fwalk(int (*function)(FILE *))
+{
+	return (__fwalk(function, 0));
+}
+
+int
+_fwalk_nowait(int (*function)(FILE *))
+{
+	return (__fwalk(function, 1));
+}
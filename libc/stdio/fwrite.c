@@ -40,7 +40,7 @@
  * Return the number of whole objects written.
  */
 size_t
-fwrite(const void *buf, size_t size, size_t count, FILE *fp)
+fwrite_unlocked(const void *buf, size_t size, size_t count, FILE *fp)
 {
 	size_t n;
 	struct __suio uio;
@@ -60,3 +60,14 @@ fwrite(const void *buf, size_t size, size_t count, FILE *fp)
 		return (count);
 	return ((n - uio.uio_resid) / size);
 }
+
+size_t
+fwrite(const void *buf, size_t size, size_t count, FILE *fp)
+{
+	size_t ret;
+
+	FLOCKFILE(fp);
+	ret = fwrite_unlocked(buf, size, count, fp);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
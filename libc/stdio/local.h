@@ -32,6 +32,7 @@
  * SUCH DAMAGE.
  */
 
+#include <pthread.h>
 #include "wcio.h"
 #include "fileext.h"
 
@@ -57,12 +58,21 @@ void	_cleanup(void);
 void	__smakebuf(FILE *);
 int	__swhatbuf(FILE *, size_t *, int *);
 int	_fwalk(int (*)(FILE *));
+int	_fwalk_nowait(int (*)(FILE *));
 int	__swsetup(FILE *);
 int	__sflags(const char *, int *);
 
 extern void __atexit_register_cleanup(void (*)(void));
 extern int __sdidinit;
 
+/*
+ * Per-FILE locking.  The public entry points take the lock around the
+ * corresponding *_unlocked() or internal routine; the internal routines
+ * (__sflush, __srefill, __sfvwrite, ...) expect it to be held already.
+ */
+#define	FLOCKFILE(fp)	flockfile(fp)
+#define	FUNLOCKFILE(fp)	funlockfile(fp)
+
 /*
  * Return true if the given FILE cannot be written now.
  */
@@ -101,10 +101,11 @@ __srefill(FILE *fp)
 	/*
 	 * Before reading from a line buffered or unbuffered file,
 	 * flush all line buffered output files, per the ANSI C
-	 * standard.
+	 * standard.  We hold fp's lock here, so the files that other
+	 * threads are busy with are skipped rather than waited for.
 	 */
 	if (fp->_flags & (__SLBF|__SNBF))
-		(void) _fwalk(lflush);
+		(void) _fwalk_nowait(lflush);
 	fp->_p = fp->_bf._base;
 	fp->_r = (*fp->_read)(fp->_cookie, (char *)fp->_p, fp->_bf._size);
 	fp->_flags &= ~__SMOD;	/* buffer contents are again pristine */
@@ -33,11 +33,14 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include "local.h"
 
 void
 rewind(FILE *fp)
 {
+	FLOCKFILE(fp);
 	(void) fseek(fp, 0L, SEEK_SET);
-	clearerr(fp);
+	clearerr_unlocked(fp);
+	FUNLOCKFILE(fp);
 	errno = 0;      /* not required, but seems reasonable */
 }
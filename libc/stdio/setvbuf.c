@@ -35,12 +35,25 @@
 #include <stdlib.h>
 #include "local.h"
 
+static int __ssetvbuf(FILE *, char *, int, size_t);
+
 /*
  * Set one of the three kinds of buffering, optionally including
  * a buffer.
  */
 int
 setvbuf(FILE *fp, char *buf, int mode, size_t size)
+{
+	int ret;
+
+	FLOCKFILE(fp);
+	ret = __ssetvbuf(fp, buf, mode, size);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
+
+static int
+__ssetvbuf(FILE *fp, char *buf, int mode, size_t size)
 {
 	int ret, flags;
 	size_t iosize;
@@ -75,8 +75,21 @@ __submore(FILE *fp)
 	return (0);
 }
 
+static int __sungetc(int, FILE *);
+
 int
 ungetc(int c, FILE *fp)
+{
+	int ret;
+
+	FLOCKFILE(fp);
+	ret = __sungetc(c, fp);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
+
+static int
+__sungetc(int c, FILE *fp)
 {
 	if (c == EOF)
 		return (EOF);
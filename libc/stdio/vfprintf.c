@@ -54,6 +54,7 @@
 static void __find_arguments(const char *fmt0, va_list ap, va_list **argtable,
     size_t *argtablesiz);
 static int __grow_type_table(unsigned char **typetable, int *tablesize);
+static int __svfprintf(FILE *, const char *, __va_list);
 
 /*
  * Flush out all the vectors defined by the given uio,
@@ -100,7 +101,7 @@ __sbprintf(FILE *fp, const char *fmt, va_list ap)
 	fake._lbfsize = 0;	/* not actually used, but Just In Case */
 
 	/* do the work, then copy any error status */
-	ret = vfprintf(&fake, fmt, ap);
+	ret = __svfprintf(&fake, fmt, ap);
 	if (ret >= 0 && fflush(&fake))
 		ret = EOF;
 	if (fake._flags & __SERR)
@@ -157,6 +158,17 @@ static  int  _my_isnan(double);
 
 int
 vfprintf(FILE *fp, const char *fmt0, __va_list ap)
+{
+	int ret;
+
+	FLOCKFILE(fp);
+	ret = __svfprintf(fp, fmt0, ap);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
+
+static int
+__svfprintf(FILE *fp, const char *fmt0, __va_list ap)
 {
 	char *fmt;	/* format string */
 	int ch;	/* character from fmt */
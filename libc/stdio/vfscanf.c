@@ -89,6 +89,7 @@
 #define u_long unsigned long
 
 static u_char *__sccl(char *, u_char *);
+static int __svfscanf(FILE *, const char *, __va_list);
 
 #if !defined(VFSCANF)
 #define VFSCANF	vfscanf
@@ -99,6 +100,17 @@ static u_char *__sccl(char *, u_char *);
  */
 int
 VFSCANF(FILE *fp, const char *fmt0, __va_list ap)
+{
+	int ret;
+
+	FLOCKFILE(fp);
+	ret = __svfscanf(fp, fmt0, ap);
+	FUNLOCKFILE(fp);
+	return (ret);
+}
+
+static int
+__svfscanf(FILE *fp, const char *fmt0, __va_list ap)
 {
 	u_char *fmt = (u_char *)fmt0;
 	int c;		/* character from format, or conversion */
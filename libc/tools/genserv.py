@@ -38,6 +38,47 @@ class Service:
 
         return result
 
+    def size(self):
+        """size of the record in the _services blob"""
+        result = 1 + len(self.name) + 4
+        for alias in self.aliases:
+            result += 1 + len(alias)
+        return result
+
+# these must match the hash functions in netbsd/net/getservent.c
+def name_hash(name):
+    h = 2166136261L
+    for c in name:
+        h = ((h ^ ord(c)) * 16777619) & 0xffffffffL
+    return h
+
+def port_hash(port):
+    return ((port * 2654435761L) & 0xffffffffL) >> 16
+
+def hash_table(entries, hash_func):
+    """build an open-addressing (linear probing) table of record offsets.
+
+       entries is a list of (key, offset) pairs; each slot holds offset+1,
+       or 0 when it is empty. the table is kept at most half full."""
+    size = 16
+    while size < 2*len(entries):
+        size *= 2
+    table = [0]*size
+    for key, offset in entries:
+        n = hash_func(key) & (size-1)
+        while table[n] != 0:
+            n = (n + 1) & (size-1)
+        table[n] = offset + 1
+    return table
+
+def format_table(name, table):
+    result  = "#define  %s_SIZE  %d\n" % (string.upper(name), len(table))
+    result += "static const unsigned short  %s[%s_SIZE] = {\n" % (name, string.upper(name))
+    for n in range(0, len(table), 8):
+        result += "    " + string.join(["%5d," % x for x in table[n:n+8]], " ") + "\n"
+    result += "};\n"
+    return result
+
 def parse(f):
     result = []  # list of Service objects
     for line in f.xreadlines():
@@ -71,6 +112,28 @@ line = '/* generated by genserv.py - do not edit */\nstatic const char  _service
 for s in services:
     line += str(s)+"\\\n"
 line += '\\0";\n'
+
+# index the records by name and alias, and by port
+names  = []
+ports  = []
+offset = 0
+for s in services:
+    keys = [s.name]
+    for alias in s.aliases:
+        if alias not in keys:
+            keys.append(alias)
+    for key in keys:
+        names.append((key, offset))
+    ports.append((s.port, offset))
+    offset += s.size()
+
+if offset >= 65535:
+    sys.stderr.write("genserv: services table too large for the index\n")
+    sys.exit(1)
+
+line += "\n/* offsets+1 of the records in _services, 0 if empty */\n"
+line += format_table("_services_name_hash", hash_table(names, name_hash))
+line += format_table("_services_port_hash", hash_table(ports, port_hash))
 print line
 
 
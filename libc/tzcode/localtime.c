@@ -21,6 +21,8 @@ static char	elsieid[] = "@(#)localtime.c	8.3";
 #include "fcntl.h"
 #include "float.h"	/* for FLT_MAX and DBL_MAX */
 
+#include <pthread.h>
+#include <sys/atomics.h>
 #include <sys/system_properties.h>
 
 #ifndef TZ_ABBR_MAX_LEN
@@ -133,8 +135,14 @@ struct state {
 	char		chars[BIGGEST(BIGGEST(TZ_MAX_CHARS + 1, sizeof gmt),
 				(2 * (MY_TZNAME_MAX + 1)))];
 	struct lsinfo	lsis[TZ_MAX_LEAPS];
+	const char *	abbrs;	/* Android: copy of chars, see lclabbrs */
 };
 
+/*
+** The abbreviations handed out through tzname and TM_ZONE.
+*/
+#define ABBR(sp, i)	(((sp)->abbrs != NULL ? (sp)->abbrs : (sp)->chars) + (i))
+
 struct rule {
 	int		r_type;		/* type of rule--see below */
 	int		r_day;		/* day number of rule */
@@ -173,7 +181,7 @@ static int		long_normalize_overflow P((long * tensptr,
 				int * unitsptr, int base));
 static int		normalize_overflow P((int * tensptr, int * unitsptr,
 				int base));
-static void		settzname P((void));
+static void		settzname P((struct state * sp));
 static time_t		time1 P((struct tm * tmp,
 				struct tm * (*funcp) P((const time_t *,
 				long, struct tm *)),
@@ -205,7 +213,6 @@ static struct state *	gmtptr;
 #ifndef ALL_STATE
 static struct state	lclmem;
 static struct state	gmtmem;
-#define lclptr		(&lclmem)
 #define gmtptr		(&gmtmem)
 #endif /* State Farm */
 
@@ -213,9 +220,61 @@ static struct state	gmtmem;
 #define TZ_STRLEN_MAX 255
 #endif /* !defined TZ_STRLEN_MAX */
 
-static char		lcl_TZname[TZ_STRLEN_MAX + 1];
-static int		lcl_is_set;
-static int		gmt_is_set;
+/*
+** Android: tzset() is called by every localtime(), localtime_r() and
+** mktime(), so it has to be cheap when nothing changed. It remembers the
+** pointer getenv("TZ") returned and the serial of persist.sys.timezone,
+** and only looks at the zone name again when one of them changes.
+**
+** Each zone is loaded into an lclzone, and lclptr is switched to it.
+** Readers take no lock, only the switch takes lcl_lock. Switching back to
+** a zone seen before reuses its state. At most LCL_ZONES_MAX zones are
+** kept; past that, loading a new one evicts the least recently used zone
+** that isn't current.
+**
+** A reader may still be using an evicted zone, so readers count
+** themselves in lcl_readers while they look at lclptr or lcl_TZname.
+** They can only find a zone while it is current, so an evicted zone
+** is freed once lcl_readers has been seen at 0 under lcl_lock. The
+** abbreviations that tzname and TM_ZONE point to are copied where they
+** are never freed.
+*/
+#define LCL_ZONES_MAX	8
+
+struct lclzone {
+	struct lclzone *	next;
+	int			wall;	/* TRUE for the system default zone */
+	unsigned		used;	/* lcl_clock when last switched to */
+	char			name[TZ_STRLEN_MAX + 1];
+	struct state		state;
+};
+
+struct lclabbrs {
+	struct lclabbrs *	next;
+	int			len;
+	char			chars[1];
+};
+
+#ifdef ALL_STATE
+static struct state * volatile	lclptr;
+#else /* !defined ALL_STATE */
+static struct state * volatile	lclptr = &lclmem;
+#endif /* !defined ALL_STATE */
+
+static pthread_mutex_t		lcl_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct lclzone *		lcl_zones;
+static struct lclzone *		lcl_current;	/* the one lclptr points to */
+static int			lcl_nzones;
+static unsigned			lcl_clock;
+static struct lclzone *		lcl_evicted;	/* waiting to be freed */
+static struct lclabbrs *	lcl_abbrs;
+static volatile int		lcl_readers;
+static const char * volatile	lcl_TZenv;	/* getenv("TZ") when last set */
+static const char * volatile	lcl_TZname;	/* its value, in an lclzone */
+static const prop_info * volatile lcl_prop;	/* persist.sys.timezone */
+static unsigned volatile	lcl_serial;	/* its serial when last set */
+static int volatile		lcl_is_set;
+static int			gmt_is_set;
 
 char *			tzname[2] = {
 	wildabbr,
@@ -268,9 +327,9 @@ const char * const	codep;
 }
 
 static void
-settzname P((void))
+settzname(sp)
+register struct state * const	sp;
 {
-	register struct state * const	sp = lclptr;
 	register int			i;
 
 	tzname[0] = wildabbr;
@@ -291,8 +350,7 @@ settzname P((void))
 	for (i = 0; i < sp->typecnt; ++i) {
 		register const struct ttinfo * const	ttisp = &sp->ttis[i];
 
-		tzname[ttisp->tt_isdst] =
-			&sp->chars[ttisp->tt_abbrind];
+		tzname[ttisp->tt_isdst] = ABBR(sp, ttisp->tt_abbrind);
 #ifdef USG_COMPAT
 		if (ttisp->tt_isdst)
 			daylight = 1;
@@ -312,8 +370,7 @@ settzname P((void))
 							&sp->ttis[
 								sp->types[i]];
 
-		tzname[ttisp->tt_isdst] =
-			&sp->chars[ttisp->tt_abbrind];
+		tzname[ttisp->tt_isdst] = ABBR(sp, ttisp->tt_abbrind);
 	}
 	/*
 	** Finally, scrub the abbreviations.
@@ -1184,81 +1241,264 @@ struct state * const	sp;
 		(void) tzparse(gmt, sp, TRUE);
 }
 
-#ifndef STD_INSPIRED
 /*
-** A non-static declaration of tzsetwall in a system header file
-** may cause a warning about this upcoming static declaration...
+** Readers call lcl_enter before they load lclptr or lcl_TZname, and
+** lcl_leave once they are done with what they found there.
 */
-static
-#endif /* !defined STD_INSPIRED */
-void
-tzsetwall P((void))
+static void
+lcl_enter P((void))
 {
-	if (lcl_is_set < 0)
-		return;
-	lcl_is_set = -1;
+	(void) __atomic_inc(&lcl_readers);
+	__memory_barrier();
+}
 
-#ifdef ALL_STATE
-	if (lclptr == NULL) {
-		lclptr = (struct state *) malloc(sizeof *lclptr);
-		if (lclptr == NULL) {
-			settzname();	/* all we can do */
-			return;
-		}
-	}
-#endif /* defined ALL_STATE */
-	if (tzload((char *) NULL, lclptr, TRUE) != 0)
-		gmtload(lclptr);
-	settzname();
+static void
+lcl_leave P((void))
+{
+	__memory_barrier();
+	(void) __atomic_dec(&lcl_readers);
 }
 
-void
-tzset P((void))
+/*
+** Return a copy of the abbreviations of sp that is never freed, sharing
+** it with the zones that have the same ones. Called with lcl_lock held,
+** after settzname has scrubbed them.
+*/
+static const char *
+lclabbrs(sp)
+const struct state * const	sp;
 {
-	register const char *	name = NULL;
-    static char buf[PROP_VALUE_MAX];
+	register struct lclabbrs *	ap;
+	register int			i, len, end;
+
+	len = strlen(sp->chars) + 1;
+	for (i = 0; i < sp->typecnt; ++i) {
+		end = sp->ttis[i].tt_abbrind +
+			strlen(&sp->chars[sp->ttis[i].tt_abbrind]) + 1;
+		if (end > len)
+			len = end;
+	}
+	for (ap = lcl_abbrs; ap != NULL; ap = ap->next)
+		if (ap->len == len && memcmp(ap->chars, sp->chars, len) == 0)
+			return ap->chars;
+	ap = (struct lclabbrs *) malloc(sizeof *ap + len);
+	if (ap == NULL)
+		return NULL;
+	ap->len = len;
+	(void) memcpy(ap->chars, sp->chars, len);
+	ap->next = lcl_abbrs;
+	lcl_abbrs = ap;
+	return ap->chars;
+}
 
-	name = getenv("TZ");
+/*
+** Move the least recently used zone that isn't current to lcl_evicted.
+** Called with lcl_lock held.
+*/
+static void
+lclevict P((void))
+{
+	register struct lclzone **	zpp;
+	register struct lclzone **	victim = NULL;
+
+	for (zpp = &lcl_zones; *zpp != NULL; zpp = &(*zpp)->next)
+		if (*zpp != lcl_current &&
+			(victim == NULL || (*zpp)->used < (*victim)->used))
+				victim = zpp;
+	if (victim != NULL) {
+		struct lclzone *	zp = *victim;
+
+		*victim = zp->next;
+		zp->next = lcl_evicted;
+		lcl_evicted = zp;
+		--lcl_nzones;
+	}
+}
 
-	// try the "persist.sys.timezone" system property first
-	if (name == NULL && __system_property_get("persist.sys.timezone", buf) > 0)
-	    name = buf;
+/*
+** Free the evicted zones if no reader can be using them. Called with
+** lcl_lock held, after lclptr and lcl_TZname have been updated, and
+** outside lcl_enter/lcl_leave.
+*/
+static void
+lclreap P((void))
+{
+	register struct lclzone *	zp;
 
-	if (name == NULL) {
-		tzsetwall();
+	if (lcl_evicted == NULL)
+		return;
+	__memory_barrier();
+	if (lcl_readers != 0)
 		return;
+	while ((zp = lcl_evicted) != NULL) {
+		lcl_evicted = zp->next;
+		free(zp);
 	}
+}
 
-	if (lcl_is_set > 0 && strcmp(lcl_TZname, name) == 0)
-		return;
-	lcl_is_set = strlen(name) < sizeof lcl_TZname;
-	if (lcl_is_set)
-		(void) strcpy(lcl_TZname, name);
+/*
+** Make lclptr point to the state of the named zone, or of the system
+** default zone if name is NULL, loading it if it isn't in lcl_zones.
+** Called with lcl_lock held. Returns the zone, or NULL if it could not be
+** allocated, in which case lclptr is left alone.
+*/
+static struct lclzone *
+lclswitch(name)
+const char *	name;
+{
+	register struct lclzone *	zp;
+	register struct state *		sp;
 
-#ifdef ALL_STATE
-	if (lclptr == NULL) {
-		lclptr = (struct state *) malloc(sizeof *lclptr);
-		if (lclptr == NULL) {
-			settzname();	/* all we can do */
-			return;
+	/*
+	** Names too long to be remembered are treated as GMT, there are
+	** no such zone files and TZ strings are far shorter in practice.
+	*/
+	if (name != NULL && strlen(name) >= sizeof zp->name)
+		name = gmt;
+	for (zp = lcl_zones; zp != NULL; zp = zp->next)
+		if (name == NULL ? zp->wall :
+			(!zp->wall && strcmp(zp->name, name) == 0))
+				break;
+	if (zp == NULL) {
+		/*
+		** Zeroed like the static lclmem was: tzparse doesn't set
+		** everything tzload does.
+		*/
+		zp = (struct lclzone *) calloc(1, sizeof *zp);
+		if (zp == NULL)
+			return NULL;
+		sp = &zp->state;
+		zp->wall = (name == NULL);
+		if (name == NULL) {
+			if (tzload((char *) NULL, sp, TRUE) != 0)
+				gmtload(sp);
+		} else {
+			(void) strcpy(zp->name, name);
+			if (*name == '\0') {
+				/*
+				** User wants it fast rather than right.
+				*/
+				sp->leapcnt = 0;	/* so, we're off a little */
+				sp->timecnt = 0;
+				sp->typecnt = 0;
+				sp->ttis[0].tt_isdst = 0;
+				sp->ttis[0].tt_gmtoff = 0;
+				sp->ttis[0].tt_abbrind = 0;
+				(void) strcpy(sp->chars, gmt);
+			} else if (tzload(name, sp, TRUE) != 0)
+				if (name[0] == ':' ||
+					tzparse(name, sp, FALSE) != 0)
+						gmtload(sp);
 		}
+		settzname(sp);
+		sp->abbrs = lclabbrs(sp);
+		if (sp->abbrs == NULL) {
+			settzname(lclptr);	/* tzname points into zp */
+			free(zp);
+			return NULL;
+		}
+		if (lcl_nzones >= LCL_ZONES_MAX)
+			lclevict();
+		zp->next = lcl_zones;
+		lcl_zones = zp;
+		++lcl_nzones;
 	}
-#endif /* defined ALL_STATE */
-	if (*name == '\0') {
+	/*
+	** settzname only rewrites abbreviations the first time it sees a
+	** state, so it is safe on a state readers may already be using.
+	*/
+	settzname(&zp->state);
+	zp->used = ++lcl_clock;
+	lcl_current = zp;
+	lclptr = &zp->state;
+	return zp;
+}
+
+#ifdef STD_INSPIRED
+void
+tzsetwall P((void))
+{
+	pthread_mutex_lock(&lcl_lock);
+	(void) lclswitch((char *) NULL);
+	lcl_is_set = 0;		/* make the next tzset look at TZ again */
+	lcl_TZname = NULL;
+	lclreap();
+	pthread_mutex_unlock(&lcl_lock);
+}
+#endif /* defined STD_INSPIRED */
+
+/*
+** tzset, but returns between lcl_enter and lcl_leave, so that the zone
+** it made current can't be freed while the caller uses it.
+*/
+static void
+lcl_tzset_enter P((void))
+{
+	const char *		env;
+	const char *		zname;
+	const prop_info *	pi;
+	unsigned		serial = 0;
+
+	env = getenv("TZ");
+	pi = lcl_prop;
+
+	// without TZ, use the "persist.sys.timezone" system property
+	if (env == NULL) {
+		if (pi == NULL)
+			pi = __system_property_find("persist.sys.timezone");
+		if (pi != NULL)
+			serial = __system_property_serial(pi);
+	}
+
+	/*
+	** setenv() may overwrite the value in place, so the same pointer
+	** doesn't mean the same zone. lcl_TZname is never written in place:
+	** it points to the name of the zone, which doesn't change.
+	*/
+	lcl_enter();
+	zname = lcl_TZname;
+	if (lcl_is_set && env == lcl_TZenv &&
+		(env != NULL ? zname != NULL && strcmp(env, zname) == 0 :
+		(pi == lcl_prop && serial == lcl_serial)))
+			return;
+	lcl_leave();
+
+	pthread_mutex_lock(&lcl_lock);
+	{
+		char			buf[PROP_VALUE_MAX];
+		const char *		name = env;
+		struct lclzone *	zp;
+
 		/*
-		** User wants it fast rather than right.
+		** The serial was taken before the value is read, so a
+		** change racing with us is seen again by the next call.
 		*/
-		lclptr->leapcnt = 0;		/* so, we're off a little */
-		lclptr->timecnt = 0;
-		lclptr->typecnt = 0;
-		lclptr->ttis[0].tt_isdst = 0;
-		lclptr->ttis[0].tt_gmtoff = 0;
-		lclptr->ttis[0].tt_abbrind = 0;
-		(void) strcpy(lclptr->chars, gmt);
-	} else if (tzload(name, lclptr, TRUE) != 0)
-		if (name[0] == ':' || tzparse(name, lclptr, FALSE) != 0)
-			(void) gmtload(lclptr);
-	settzname();
+		if (name == NULL && pi != NULL &&
+			__system_property_read(pi, NULL, buf) > 0)
+				name = buf;
+		if ((zp = lclswitch(name)) != NULL) {
+			/*
+			** Names too long to keep never match the name of
+			** the GMT zone lclswitch uses for them, so they
+			** always take this path.
+			*/
+			lcl_TZname = (env != NULL) ? zp->name : NULL;
+			lcl_TZenv = env;
+			lcl_prop = pi;
+			lcl_serial = serial;
+			lcl_is_set = (name == NULL) ? -1 : TRUE;
+		}
+		lclreap();
+	}
+	pthread_mutex_unlock(&lcl_lock);
+	lcl_enter();
+}
+
+void
+tzset P((void))
+{
+	lcl_tzset_enter();
+	lcl_leave();
 }
 
 /*
@@ -1356,9 +1596,9 @@ struct tm * const	tmp;
 	*/
 	result = timesub(&t, ttisp->tt_gmtoff, sp, tmp);
 	tmp->tm_isdst = ttisp->tt_isdst;
-	tzname[tmp->tm_isdst] = &sp->chars[ttisp->tt_abbrind];
+	tzname[tmp->tm_isdst] = ABBR(sp, ttisp->tt_abbrind);
 #ifdef TM_ZONE
-	tmp->TM_ZONE = &sp->chars[ttisp->tt_abbrind];
+	tmp->TM_ZONE = ABBR(sp, ttisp->tt_abbrind);
 #endif /* defined TM_ZONE */
 	return result;
 }
@@ -1367,8 +1607,12 @@ struct tm *
 localtime(timep)
 const time_t * const	timep;
 {
-	tzset();
-	return localsub(timep, 0L, &tm);
+	struct tm *	result;
+
+	lcl_tzset_enter();
+	result = localsub(timep, 0L, &tm);
+	lcl_leave();
+	return result;
 }
 
 /*
@@ -1380,8 +1624,12 @@ localtime_r(timep, tmp)
 const time_t * const	timep;
 struct tm *		tmp;
 {
-        tzset();
-	return localsub(timep, 0L, tmp);
+	struct tm *	result;
+
+	lcl_tzset_enter();
+	result = localsub(timep, 0L, tmp);
+	lcl_leave();
+	return result;
 }
 
 /*
@@ -2002,8 +2250,12 @@ time_t
 mktime(tmp)
 struct tm * const	tmp;
 {
-	tzset();
-	return time1(tmp, localsub, 0L);
+	time_t	result;
+
+	lcl_tzset_enter();
+	result = time1(tmp, localsub, 0L);
+	lcl_leave();
+	return result;
 }
 
 #ifdef STD_INSPIRED
@@ -2076,15 +2328,20 @@ time_t *	timep;
 	register struct state *		sp;
 	register struct lsinfo *	lp;
 	register int			i;
+	long				corr = 0;
 
+	lcl_enter();
 	sp = lclptr;
 	i = sp->leapcnt;
 	while (--i >= 0) {
 		lp = &sp->lsis[i];
-		if (*timep >= lp->ls_trans)
-			return lp->ls_corr;
+		if (*timep >= lp->ls_trans) {
+			corr = lp->ls_corr;
+			break;
+		}
 	}
-	return 0;
+	lcl_leave();
+	return corr;
 }
 
 time_t
@@ -59,32 +59,51 @@ void *dlopen(const char *filename, int flag)
 
 const char *dlerror(void)
 {
-    const char *err = dl_errors[dl_last_err];
+    const char *err;
+
+    pthread_mutex_lock(&dl_lock);
+    err = dl_errors[dl_last_err];
     dl_last_err = DL_SUCCESS;
+    pthread_mutex_unlock(&dl_lock);
     return err;
 }
 
+/* for the callers that don't otherwise hold dl_lock */
+static void dl_set_error(int err)
+{
+    pthread_mutex_lock(&dl_lock);
+    dl_last_err = err;
+    pthread_mutex_unlock(&dl_lock);
+}
+
+/* dlsym() does not take dl_lock: it only looks at objects that are
+ * already linked, through the snapshot that the linker publishes after
+ * every load and unload, so concurrent callers never serialize. Only
+ * failures take the lock, to record the error.
+ */
 void *dlsym(void *handle, const char *symbol)
 {
     unsigned base;
     Elf32_Sym *sym;
     unsigned bind;
+    int token;
+    int err;
 
-    pthread_mutex_lock(&dl_lock);
-    
     if(unlikely(handle == 0)) { 
-        dl_last_err = DL_ERR_INVALID_LIBRARY_HANDLE;
-        goto err;
+        dl_set_error(DL_ERR_INVALID_LIBRARY_HANDLE);
+        return 0;
     }
     if(unlikely(symbol == 0)) {
-        dl_last_err = DL_ERR_BAD_SYMBOL_NAME;
-        goto err;
+        dl_set_error(DL_ERR_BAD_SYMBOL_NAME);
+        return 0;
     }
-    
+
+    token = solist_read_begin();
+
     if(handle == RTLD_DEFAULT) {
-        sym = lookup(symbol, &base);
+        sym = lookup(token, symbol, &base);
     } else if(handle == RTLD_NEXT) {
-        sym = lookup(symbol, &base);
+        sym = lookup(token, symbol, &base);
     } else {
         sym = lookup_in_library((soinfo*) handle, symbol);
         base = ((soinfo*) handle)->base;
@@ -95,16 +114,16 @@ void *dlsym(void *handle, const char *symbol)
     
         if(likely((bind == STB_GLOBAL) && (sym->st_shndx != 0))) {
             unsigned ret = sym->st_value + base;
-            pthread_mutex_unlock(&dl_lock);
+            solist_read_end(token);
             return (void*)ret;
         }
 
-        dl_last_err = DL_ERR_SYMBOL_NOT_GLOBAL;
+        err = DL_ERR_SYMBOL_NOT_GLOBAL;
     }
-    else dl_last_err = DL_ERR_SYMBOL_NOT_FOUND;
+    else err = DL_ERR_SYMBOL_NOT_FOUND;
 
-err:
-    pthread_mutex_unlock(&dl_lock);
+    solist_read_end(token);
+    dl_set_error(err);
     return 0;
 }
 
@@ -11,6 +11,7 @@
 //#include <pthread.h>
 
 #include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <sys/atomics.h>
 #include <sys/tls.h>
@@ -18,7 +19,12 @@
 #include "linker.h"
 #include "linker_debug.h"
 
-#define SO_MAX 64
+/* soinfo structs are allocated in pools of this many pages */
+#define SOINFO_POOL_PAGES   4
+#define SOINFO_PER_POOL     ((SOINFO_POOL_PAGES * PAGE_SIZE) / sizeof(soinfo))
+
+/* number of buckets in the library name hash; must be a power of two */
+#define SONAME_HASH_SIZE    64
 
 /* >>> IMPORTANT NOTE - READ ME BEFORE MODIFYING <<<
  *
@@ -38,8 +44,6 @@
  *   and NOEXEC
  * - linker hardcodes PAGE_SIZE and PAGE_MASK because the kernel
  *   headers provide versions that are negative...
- * - allocate space for soinfo structs dynamically instead of
- *   having a hard limit (64)
  *
  * features to add someday:
  *
@@ -51,14 +55,63 @@
 static int link_image(soinfo *si, unsigned wr_offset);
 
 static int socount = 0;
-static soinfo sopool[SO_MAX];
 static soinfo *freelist = NULL;
 static soinfo *solist = &libdl_info;
 static soinfo *sonext = &libdl_info;
 
+/* soinfo structs hashed by library name, used by find_library() */
+static soinfo *soname_hash[SONAME_HASH_SIZE];
+
+/* loaded objects sorted by base address, used to map a PC back to the
+ * object that contains it (see find_containing_library()) */
+static soinfo **soaddr_index = NULL;
+static unsigned soaddr_count = 0;
+static unsigned soaddr_capacity = 0;
+
+/* An immutable copy of solist (linked objects only) and of the address
+ * index, for readers that don't hold the dlfcn.c dl_lock: dlsym() and
+ * the PC-to-library queries.
+ *
+ * There are two snapshot slots. Writers (which are serialized, either by
+ * running before main() or by dl_lock) fill in the slot that is not
+ * current, then publish it by bumping sosnapshot_epoch. Readers count
+ * themselves in sosnapshot_readers[] for the slot they use (see
+ * solist_read_begin()), and a writer waits for that count to drop to zero
+ * before reusing a slot, or before unmapping a library that a previous
+ * snapshot referenced.
+ */
+typedef struct {
+    unsigned size;          /* bytes mapped for this snapshot */
+    unsigned nload;         /* entries in by_load, in solist order */
+    unsigned naddr;         /* entries in by_addr, sorted by base */
+    soinfo **by_load;
+    soinfo **by_addr;
+} sosnapshot;
+
+static sosnapshot *sosnapshots[2];
+static volatile int sosnapshot_epoch = 0;
+static volatile int sosnapshot_readers[2];
+
+/* Library mappings that are off the lists, but still referenced by the
+ * current snapshot because the one without them could not be published.
+ * They are unmapped after the next successful publish_solist(). */
+#define UNMAP_PENDING_MAX 16
+
+static struct {
+    unsigned base;
+    unsigned size;
+} unmap_pending[UNMAP_PENDING_MAX];
+static unsigned unmap_pending_count;
+
 int debug_verbosity;
 static int pid;
 
+/* Set from LD_BIND_LAZY=1 in the environment (see link_image()) */
+static int bind_lazy = 0;
+
+/* Set from LD_RELRO_CACHE=<dir> in the environment (see relro_cache_map()) */
+static const char *relro_cache_dir = NULL;
+
 #if STATS
 struct _link_stats linker_stats;
 #endif
@@ -67,6 +120,10 @@ struct _link_stats linker_stats;
 unsigned bitmask[4096];
 #endif
 
+#ifndef PT_GNU_RELRO
+#define PT_GNU_RELRO    0x6474e552      /* read-only after relocation */
+#endif
+
 #ifndef PT_ARM_EXIDX
 #define PT_ARM_EXIDX    0x70000001      /* .ARM.exidx segment */
 #endif
@@ -148,6 +205,257 @@ void notify_gdb_of_libraries()
     rtld_db_dlactivity();
 }
 
+static unsigned elfhash(const char *_name);
+
+static void soname_hash_insert(soinfo *si)
+{
+    soinfo **pp = &soname_hash[elfhash(si->name) & (SONAME_HASH_SIZE - 1)];
+
+    /* Append, so that the first library loaded under a given name is the
+     * one found, just like when walking solist. */
+    while (*pp != NULL)
+        pp = &(*pp)->hash_next;
+    si->hash_next = NULL;
+    *pp = si;
+}
+
+static void soname_hash_remove(soinfo *si)
+{
+    soinfo **pp = &soname_hash[elfhash(si->name) & (SONAME_HASH_SIZE - 1)];
+
+    for (; *pp != NULL; pp = &(*pp)->hash_next) {
+        if (*pp == si) {
+            *pp = si->hash_next;
+            si->hash_next = NULL;
+            return;
+        }
+    }
+}
+
+static soinfo *soname_hash_find(const char *name)
+{
+    soinfo *si = soname_hash[elfhash(name) & (SONAME_HASH_SIZE - 1)];
+
+    for (; si != NULL; si = si->hash_next) {
+        if (!strcmp(name, si->name))
+            return si;
+    }
+    return NULL;
+}
+
+/* Add si to the address index. si->base and si->size must be set. */
+static int soaddr_insert(soinfo *si)
+{
+    unsigned lo = 0, hi = soaddr_count, mid;
+
+    if (soaddr_count == soaddr_capacity) {
+        unsigned capacity = soaddr_capacity ? soaddr_capacity * 2
+                                            : PAGE_SIZE / sizeof(soinfo *);
+        soinfo **index = mmap(NULL, capacity * sizeof(soinfo *),
+                              PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (index == MAP_FAILED) {
+            ERROR("%5d cannot grow the address index for '%s'\n",
+                  pid, si->name);
+            return -1;
+        }
+        if (soaddr_index != NULL) {
+            memcpy(index, soaddr_index, soaddr_count * sizeof(soinfo *));
+            munmap(soaddr_index, soaddr_capacity * sizeof(soinfo *));
+        }
+        soaddr_index = index;
+        soaddr_capacity = capacity;
+    }
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (soaddr_index[mid]->base < si->base)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    memmove(soaddr_index + lo + 1, soaddr_index + lo,
+            (soaddr_count - lo) * sizeof(soinfo *));
+    soaddr_index[lo] = si;
+    soaddr_count++;
+    return 0;
+}
+
+static void soaddr_remove(soinfo *si)
+{
+    unsigned n;
+
+    for (n = 0; n < soaddr_count; n++) {
+        if (soaddr_index[n] == si) {
+            memmove(soaddr_index + n, soaddr_index + n + 1,
+                    (soaddr_count - n - 1) * sizeof(soinfo *));
+            soaddr_count--;
+            return;
+        }
+    }
+}
+
+/* Wait until no reader is using the snapshot slot that is not current.
+ * After a new snapshot has been published, this guarantees that nobody
+ * can still see what was only in the previous one. */
+static void synchronize_solist(void)
+{
+    volatile int *readers = &sosnapshot_readers[(sosnapshot_epoch + 1) & 1];
+
+    while (*readers != 0)
+        sched_yield();
+}
+
+/* Rebuild the snapshot from solist and soaddr_index, and make it current.
+ * Must only be called by a serialized writer. */
+static int publish_solist(void)
+{
+    int slot = (sosnapshot_epoch + 1) & 1;
+    sosnapshot *snap = sosnapshots[slot];
+    unsigned nload = 0;
+    unsigned size;
+    soinfo *si;
+
+    for (si = solist; si != NULL; si = si->next)
+        nload++;
+    size = sizeof(sosnapshot) + (nload + soaddr_count) * sizeof(soinfo *);
+    size = (size + PAGE_SIZE - 1) & (~PAGE_MASK);
+
+    /* stale readers may still be looking at this slot */
+    synchronize_solist();
+
+    if (snap == NULL || snap->size < size) {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            ERROR("%5d cannot allocate library list snapshot\n", pid);
+            return -1;
+        }
+        if (snap != NULL)
+            munmap(snap, snap->size);
+        snap = (sosnapshot *)p;
+        snap->size = size;
+        sosnapshots[slot] = snap;
+    }
+
+    snap->by_load = (soinfo **)(snap + 1);
+    snap->nload = 0;
+    for (si = solist; si != NULL; si = si->next) {
+        if ((si->flags & (FLAG_LINKED | FLAG_ERROR)) == FLAG_LINKED)
+            snap->by_load[snap->nload++] = si;
+    }
+    snap->by_addr = snap->by_load + snap->nload;
+    snap->naddr = soaddr_count;
+    memcpy(snap->by_addr, soaddr_index, soaddr_count * sizeof(soinfo *));
+
+    __atomic_inc(&sosnapshot_epoch);
+
+    if (unmap_pending_count > 0) {
+        unsigned n;
+
+        synchronize_solist();
+        for (n = 0; n < unmap_pending_count; n++)
+            munmap((void *)unmap_pending[n].base, unmap_pending[n].size);
+        unmap_pending_count = 0;
+    }
+    return 0;
+}
+
+/* Unmap a library that has been taken off solist and the address index.
+ * Lock-free readers may still be using it through the current snapshot,
+ * so a new one must be published first, and its predecessor drained. If
+ * that fails for lack of memory, the unmap is left to the next publish,
+ * and only when too many are pending do we wait for memory to show up. */
+static void unmap_library(soinfo *si)
+{
+    if (publish_solist() == 0) {
+        synchronize_solist();
+        munmap((void *)si->base, si->size);
+        return;
+    }
+    if (unmap_pending_count < UNMAP_PENDING_MAX) {
+        unmap_pending[unmap_pending_count].base = si->base;
+        unmap_pending[unmap_pending_count].size = si->size;
+        unmap_pending_count++;
+        return;
+    }
+    while (publish_solist() < 0)
+        usleep(5000);
+    synchronize_solist();
+    munmap((void *)si->base, si->size);
+}
+
+/* Enter a read-side section. The returned token must be passed to
+ * solist_read_end(). Never blocks. */
+int solist_read_begin(void)
+{
+    int epoch;
+
+    for (;;) {
+        epoch = sosnapshot_epoch;
+        __atomic_inc(&sosnapshot_readers[epoch & 1]);
+        if (epoch == sosnapshot_epoch)
+            return epoch & 1;
+        /* A writer published in between; it may already be refilling
+         * the slot we counted ourselves in. */
+        __atomic_dec(&sosnapshot_readers[epoch & 1]);
+    }
+}
+
+void solist_read_end(int token)
+{
+    __atomic_dec(&sosnapshot_readers[token]);
+}
+
+/* Returns the loaded object whose [base, base + size) range contains
+ * addr, or NULL. Must be called within a read-side section. */
+static soinfo *find_containing_library(int token, unsigned addr)
+{
+    sosnapshot *snap = sosnapshots[token];
+    unsigned lo = 0, hi, mid;
+    soinfo *si;
+
+    if (snap == NULL)
+        return NULL;
+
+    /* find the last object with base <= addr */
+    hi = snap->naddr;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (snap->by_addr[mid]->base <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return NULL;
+
+    si = snap->by_addr[lo - 1];
+    if (addr < si->base + si->size)
+        return si;
+    return NULL;
+}
+
+/* Carve a new pool of soinfo structs out of an anonymous mapping and put
+ * them on the freelist. */
+static int alloc_soinfo_pool(void)
+{
+    soinfo *pool;
+    unsigned n;
+
+    pool = mmap(NULL, SOINFO_POOL_PAGES * PAGE_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pool == MAP_FAILED)
+        return -1;
+
+    for (n = 0; n < SOINFO_PER_POOL; n++) {
+        pool[n].next = freelist;
+        freelist = &pool[n];
+    }
+    socount += SOINFO_PER_POOL;
+    return 0;
+}
+
 static soinfo *alloc_info(const char *name)
 {
     soinfo *si;
@@ -158,15 +466,15 @@ static soinfo *alloc_info(const char *name)
     }
 
     /* The freelist is populated when we call free_info(), which in turn is
-       done only by dlclose(), which is not likely to be used.
+       done only by dlclose(), which is not likely to be used, and whenever
+       we run out of entries and allocate a new pool.
     */
     if (!freelist) {
-        if(socount == SO_MAX) {
-            ERROR("%5d too many libraries when loading %s\n", pid, name);
+        if (alloc_soinfo_pool() < 0) {
+            ERROR("%5d cannot allocate soinfo when loading %s (%d so far)\n",
+                  pid, name, socount);
             return NULL;
         }
-        freelist = sopool + socount++;
-        freelist->next = NULL;
     }
 
     si = freelist;
@@ -179,6 +487,7 @@ static soinfo *alloc_info(const char *name)
     si->next = NULL;
     si->refcount = 0;
     sonext = si;
+    soname_hash_insert(si);
 
     TRACE("%5d name %s: allocated soinfo @ %p\n", pid, name, si);
     return si;
@@ -206,6 +515,8 @@ static void free_info(soinfo *si)
     */
     prev->next = si->next;
     if (si == sonext) sonext = prev;
+    soname_hash_remove(si);
+    soaddr_remove(si);
     si->next = freelist;
     freelist = si;
 }
@@ -222,12 +533,13 @@ static void free_info(soinfo *si)
 const char *addr_to_name(unsigned addr)
 {
     soinfo *si;
+    int token;
 
-    for(si = solist; si != 0; si = si->next){
-        if((addr >= si->base) && (addr < (si->base + si->size))) {
-            return si->name;
-        }
-    }
+    token = solist_read_begin();
+    si = find_containing_library(token, addr);
+    solist_read_end(token);
+    if (si != NULL)
+        return si->name;
 
     if((addr >= LINKER_BASE) && (addr < LINKER_TOP)){
         return "linker";
@@ -252,12 +564,15 @@ _Unwind_Ptr dl_unwind_find_exidx(_Unwind_Ptr pc, int *pcount)
     unsigned addr = (unsigned)pc;
 
     if ((addr < LINKER_BASE) || (addr >= LINKER_TOP)) {
-        for (si = solist; si != 0; si = si->next){
-            if ((addr >= si->base) && (addr < (si->base + si->size))) {
-                *pcount = si->ARM_exidx_count;
-                return (_Unwind_Ptr)(si->base + (unsigned long)si->ARM_exidx);
-            }
+        int token = solist_read_begin();
+        si = find_containing_library(token, addr);
+        if (si != NULL) {
+            *pcount = si->ARM_exidx_count;
+            addr = si->base + (unsigned long)si->ARM_exidx;
+            solist_read_end(token);
+            return (_Unwind_Ptr)addr;
         }
+        solist_read_end(token);
     }
    *pcount = 0;
     return NULL;
@@ -317,6 +632,52 @@ static Elf32_Sym *_elf_lookup(soinfo *si, unsigned hash, const char *name)
     return 0;
 }
 
+/* Same as _elf_lookup(), but uses the DT_GNU_HASH table. The Bloom filter
+ * is checked first, so that most misses are rejected with a single load
+ * and without touching the bucket, chain or string tables.
+ */
+static Elf32_Sym *_gnu_lookup(soinfo *si, unsigned hash, const char *name)
+{
+    Elf32_Sym *s;
+    Elf32_Sym *symtab = si->symtab;
+    const char *strtab = si->strtab;
+    unsigned word, mask;
+    unsigned n;
+
+    TRACE_TYPE(LOOKUP, "%5d SEARCH (gnu) %s in %s@0x%08x %08x %d\n", pid,
+               name, si->name, si->base, hash, hash % si->gnu_nbucket);
+
+    word = si->gnu_bloom_filter[(hash / 32) % si->gnu_maskwords];
+    mask = (1U << (hash % 32)) | (1U << ((hash >> si->gnu_shift2) % 32));
+    if ((word & mask) != mask)
+        return 0;
+
+    n = si->gnu_bucket[hash % si->gnu_nbucket];
+    if (n == 0)
+        return 0;
+
+    do {
+        s = symtab + n;
+            /* the low bit of a chain entry marks the end of the chain */
+        if (((si->gnu_chain[n] ^ hash) >> 1) != 0) continue;
+        if (strcmp(strtab + s->st_name, name)) continue;
+
+            /* only concern ourselves with global symbols */
+        switch(ELF32_ST_BIND(s->st_info)){
+        case STB_GLOBAL:
+                /* no section == undefined */
+            if(s->st_shndx == 0) continue;
+
+        case STB_WEAK:
+            TRACE_TYPE(LOOKUP, "%5d FOUND %s in %s (%08x) %d\n", pid,
+                       name, si->name, s->st_value, s->st_size);
+            return s;
+        }
+    } while ((si->gnu_chain[n++] & 1) == 0);
+
+    return 0;
+}
+
 static unsigned elfhash(const char *_name)
 {
     const unsigned char *name = (const unsigned char *) _name;
@@ -331,9 +692,29 @@ static unsigned elfhash(const char *_name)
     return h;
 }
 
+static unsigned gnuhash(const char *_name)
+{
+    const unsigned char *name = (const unsigned char *) _name;
+    unsigned h = 5381;
+
+    while(*name)
+        h = (h << 5) + h + *name++;
+    return h;
+}
+
+/* The hashes are computed lazily and cached by the caller, since a single
+ * lookup may visit libraries with either kind of hash table. A value of
+ * zero means "not computed yet".
+ */
 static Elf32_Sym *
-_do_lookup_in_so(soinfo *si, const char *name, unsigned *elf_hash)
+_do_lookup_in_so(soinfo *si, const char *name, unsigned *elf_hash,
+                 unsigned *gnu_hash)
 {
+    if (si->gnu_bucket != NULL) {
+        if (*gnu_hash == 0)
+            *gnu_hash = gnuhash(name);
+        return _gnu_lookup(si, *gnu_hash, name);
+    }
     if (*elf_hash == 0)
         *elf_hash = elfhash(name);
     return _elf_lookup (si, *elf_hash, name);
@@ -342,14 +723,16 @@ _do_lookup_in_so(soinfo *si, const char *name, unsigned *elf_hash)
 /* This is used by dl_sym() */
 Elf32_Sym *lookup_in_library(soinfo *si, const char *name)
 {
-    unsigned unused = 0;
-    return _do_lookup_in_so(si, name, &unused);
+    unsigned elf_hash = 0;
+    unsigned gnu_hash = 0;
+    return _do_lookup_in_so(si, name, &elf_hash, &gnu_hash);
 }
 
 static Elf32_Sym *
 _do_lookup(soinfo *user_si, const char *name, unsigned *base)
 {
     unsigned elf_hash = 0;
+    unsigned gnu_hash = 0;
     Elf32_Sym *s = NULL;
     soinfo *si;
 
@@ -357,7 +740,7 @@ _do_lookup(soinfo *user_si, const char *name, unsigned *base)
      * searching). This happens with C++ templates on i386 for some
      * reason. */
     if (user_si) {
-        s = _do_lookup_in_so(user_si, name, &elf_hash);
+        s = _do_lookup_in_so(user_si, name, &elf_hash, &gnu_hash);
         if (s != NULL)
             *base = user_si->base;
     }
@@ -366,7 +749,7 @@ _do_lookup(soinfo *user_si, const char *name, unsigned *base)
     {
         if((si->flags & FLAG_ERROR) || (si == user_si))
             continue;
-        s = _do_lookup_in_so(si, name, &elf_hash);
+        s = _do_lookup_in_so(si, name, &elf_hash, &gnu_hash);
         if (s != NULL) {
             *base = si->base;
             break;
@@ -382,10 +765,46 @@ _do_lookup(soinfo *user_si, const char *name, unsigned *base)
     return 0;
 }
 
+/* Same as _do_lookup(), but walks the published snapshot of linked
+ * objects, so it doesn't need the dl_lock. It must be called within the
+ * read-side section identified by token (see solist_read_begin()). */
+static Elf32_Sym *
+_do_lookup_in_snapshot(int token, soinfo *user_si, const char *name,
+                       unsigned *base)
+{
+    unsigned elf_hash = 0;
+    unsigned gnu_hash = 0;
+    sosnapshot *snap = sosnapshots[token];
+    Elf32_Sym *s;
+    unsigned n;
+
+    if (user_si) {
+        s = _do_lookup_in_so(user_si, name, &elf_hash, &gnu_hash);
+        if (s != NULL) {
+            *base = user_si->base;
+            return s;
+        }
+    }
+
+    if (snap == NULL)
+        return NULL;
+
+    for (n = 0; n < snap->nload; n++) {
+        if (snap->by_load[n] == user_si)
+            continue;
+        s = _do_lookup_in_so(snap->by_load[n], name, &elf_hash, &gnu_hash);
+        if (s != NULL) {
+            *base = snap->by_load[n]->base;
+            return s;
+        }
+    }
+    return NULL;
+}
+
 /* This is used by dl_sym() */
-Elf32_Sym *lookup(const char *name, unsigned *base)
+Elf32_Sym *lookup(int token, const char *name, unsigned *base)
 {
-    return _do_lookup(NULL, name, base);
+    return _do_lookup_in_snapshot(token, NULL, name, base);
 }
 
 #if 0
@@ -470,6 +889,21 @@ is_prelinked(int fd, const char *name)
     return (unsigned long)info.mmap_addr;
 }
 
+/* Records the identity of the file behind fd for the RELRO cache. Leaves
+ * id->ino at 0 if it can't be determined. */
+static void get_file_id(int fd, file_id *id)
+{
+    struct stat st;
+
+    memset(id, 0, sizeof(*id));
+    if (fstat(fd, &st) < 0)
+        return;
+    id->dev = st.st_dev;
+    id->ino = st.st_ino;
+    id->size = st.st_size;
+    id->mtime = st.st_mtime;
+}
+
 /* verify_elf_object
  *      Verifies if the object @ base is a valid ELF object
  *
@@ -786,6 +1220,15 @@ load_segments(int fd, void *header, soinfo *si)
             DEBUG_DUMP_PHDR(phdr, "PT_DYNAMIC", pid);
             /* this segment contains the dynamic linking information */
             si->dynamic = (unsigned *)(base + phdr->p_vaddr);
+        } else if (phdr->p_type == PT_GNU_RELRO) {
+            DEBUG_DUMP_PHDR(phdr, "PT_GNU_RELRO", pid);
+            /* only whole pages can be shared (see relro_cache_map()) */
+            si->relro_start = ((unsigned)base + phdr->p_vaddr + PAGE_SIZE - 1) &
+                              (~PAGE_MASK);
+            si->relro_end = ((unsigned)base + phdr->p_vaddr + phdr->p_memsz) &
+                            (~PAGE_MASK);
+            if (si->relro_end <= si->relro_start)
+                si->relro_start = si->relro_end = 0;
         } else {
 #ifdef ANDROID_ARM_LINKER
             if (phdr->p_type == PT_ARM_EXIDX) {
@@ -916,10 +1359,19 @@ load_library(const char *name)
     si->entry = 0;
     si->dynamic = (unsigned *)-1;
 
+    if (relro_cache_dir != NULL)
+        get_file_id(fd, &si->file);
+
     /* Now actually load the library's segments into right places in memory */
     if (load_segments(fd, &__header[0], si) < 0)
         goto fail;
 
+    if (soaddr_insert(si) < 0) {
+        munmap((void *)si->base, si->size);
+        si->flags |= FLAG_ERROR;
+        goto fail;
+    }
+
     /* this might not be right. Technically, we don't even need this info
      * once we go through 'load_segments'. */
     hdr = (Elf32_Ehdr *)base;
@@ -968,7 +1420,9 @@ init_library(soinfo *si)
         if(!(si->flags & FLAG_PRELINKED) && (libbase == libbase_after)) {
             libbase = libbase_before;
         }
-        munmap((void *)si->base, si->size);
+        soaddr_remove(si);
+        /* Lock-free readers may have seen our address range. */
+        unmap_library(si);
         return NULL;
     }
 
@@ -979,13 +1433,12 @@ soinfo *find_library(const char *name)
 {
     soinfo *si;
 
-    for(si = solist; si != 0; si = si->next){
-        if(!strcmp(name, si->name)) {
-            if(si->flags & FLAG_ERROR) return 0;
-            if(si->flags & FLAG_LINKED) return si;
-            ERROR("OOPS: %5d recursive link to '%s'\n", pid, si->name);
-            return 0;
-        }
+    si = soname_hash_find(name);
+    if(si != NULL) {
+        if(si->flags & FLAG_ERROR) return 0;
+        if(si->flags & FLAG_LINKED) return si;
+        ERROR("OOPS: %5d recursive link to '%s'\n", pid, si->name);
+        return 0;
     }
 
     TRACE("[ %5d '%s' has not been loaded yet.  Locating...]\n", pid, name);
@@ -1020,8 +1473,11 @@ unsigned unload_library(soinfo *si)
             }
         }
 
-        munmap((char *)si->base, si->size);
+        /* Take si off the lists and make sure that no lock-free reader
+         * can still see it before unmapping it. free_info() leaves si
+         * untouched except for its list linkage. */
         free_info(si);
+        unmap_library(si);
         si->refcount = 0;
     }
     else {
@@ -1032,6 +1488,68 @@ unsigned unload_library(soinfo *si)
     return si->refcount;
 }
 
+/* Many relocations in a library usually refer to the same symbol (e.g.
+ * the GLOB_DAT and JUMP_SLOT entries for a function whose address is
+ * also taken). To avoid hashing and searching every library again for
+ * each of them, we remember the result of each lookup by symbol index
+ * while the library is being relocated. The cache is sized by the largest
+ * symbol index used in the relocation tables, and is mapped anonymously
+ * since we can't use malloc() here.
+ */
+static unsigned max_reloc_sym(Elf32_Rel *rel, unsigned count)
+{
+    unsigned max = 0;
+
+    for (; count > 0; --count, ++rel) {
+        if (ELF32_R_SYM(rel->r_info) > max)
+            max = ELF32_R_SYM(rel->r_info);
+    }
+    return max;
+}
+
+static void alloc_symcache(soinfo *si)
+{
+    unsigned max = 0;
+    unsigned n;
+    unsigned sz;
+    void *p;
+
+    if (si->plt_rel)
+        max = max_reloc_sym(si->plt_rel, si->plt_rel_count);
+    if (si->rel) {
+        n = max_reloc_sym(si->rel, si->rel_count);
+        if (n > max)
+            max = n;
+    }
+    if (max == 0)
+        return;
+
+    sz = ((max + 1) * sizeof(symcache_entry) + PAGE_SIZE - 1) & (~PAGE_MASK);
+    p = mmap(NULL, sz, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        /* Not fatal, we will just look every symbol up. */
+        WARN("%5d could not allocate symbol cache for '%s'\n",
+             pid, si->name);
+        return;
+    }
+    si->symcache = (symcache_entry *)p;
+    si->symcache_size = max + 1;
+}
+
+static void free_symcache(soinfo *si)
+{
+    unsigned sz;
+
+    if (si->symcache == NULL)
+        return;
+    sz = (si->symcache_size * sizeof(symcache_entry) + PAGE_SIZE - 1) &
+         (~PAGE_MASK);
+    munmap(si->symcache, sz);
+    si->symcache = NULL;
+    si->symcache_size = 0;
+}
+
 /* TODO: don't use unsigned for addrs below. It works, but is not
  * ideal. They should probably be either uint32_t, Elf32_Addr, or unsigned
  * long.
@@ -1054,11 +1572,29 @@ static int reloc_library(soinfo *si, Elf32_Rel *rel, unsigned count)
 
         DEBUG("%5d Processing '%s' relocation at index %d\n", pid,
               si->name, idx);
+        if ((si->flags & FLAG_RELRO_SHARED) &&
+            (reloc >= si->relro_start) && (reloc < si->relro_end)) {
+            /* already relocated, mapped from the RELRO cache */
+            rel++;
+            continue;
+        }
         if(sym != 0) {
-            s = _do_lookup(si, strtab + symtab[sym].st_name, &base);
-            if(s == 0) {
-                ERROR("%5d cannot locate '%s'...\n", pid, sym_name);
-                return -1;
+            if ((sym < si->symcache_size) && (si->symcache[sym].s != NULL)) {
+                s = si->symcache[sym].s;
+                base = si->symcache[sym].base;
+                COUNT_RELOC(RELOC_SYMCACHE_HIT);
+            } else {
+                s = _do_lookup(si, strtab + symtab[sym].st_name, &base);
+                if(s == 0) {
+                    ERROR("%5d cannot locate '%s'...\n", pid,
+                          strtab + symtab[sym].st_name);
+                    return -1;
+                }
+                if (sym < si->symcache_size) {
+                    si->symcache[sym].s = s;
+                    si->symcache[sym].base = base;
+                }
+                COUNT_RELOC(RELOC_SYMCACHE_MISS);
             }
 #if 0
             if((base == 0) && (si->base != 0)){
@@ -1168,6 +1704,297 @@ static int reloc_library(soinfo *si, Elf32_Rel *rel, unsigned count)
     return 0;
 }
 
+/* Apply the packed relative relocations found in DT_RELR.
+ *
+ * The table is a sequence of words. An even word is the address (relative
+ * to the load base) of a word to relocate, and sets the start of the
+ * region that the following bitmaps describe. An odd word is a bitmap:
+ * bit N (for N in 1..31) set means that the word N-1 words past the
+ * current region start needs to be relocated. Each bitmap then advances
+ * the region start by 31 words.
+ */
+static int reloc_relr(soinfo *si, unsigned *relr, unsigned count)
+{
+    unsigned *where = NULL;
+    unsigned *p;
+    unsigned *end = relr + count;
+    unsigned base = si->base;
+    /* pages mapped from the RELRO cache are already relocated */
+    unsigned *skip_start = NULL, *skip_end = NULL;
+
+    if (si->flags & FLAG_RELRO_SHARED) {
+        skip_start = (unsigned *)si->relro_start;
+        skip_end = (unsigned *)si->relro_end;
+    }
+
+    for (; relr < end; relr++) {
+        unsigned entry = *relr;
+
+        if ((entry & 1) == 0) {
+            where = (unsigned *)(base + entry);
+            COUNT_RELOC(RELOC_RELATIVE);
+            MARK(entry);
+            if (where < skip_start || where >= skip_end)
+                *where += base;
+            where++;
+            continue;
+        }
+
+        if (where == NULL) {
+            ERROR("%5d bad DT_RELR table in '%s'\n", pid, si->name);
+            return -1;
+        }
+
+        for (p = where, entry >>= 1; entry != 0; entry >>= 1, p++) {
+            if ((entry & 1) && (p < skip_start || p >= skip_end)) {
+                COUNT_RELOC(RELOC_RELATIVE);
+                MARK((unsigned)p - base);
+                *p += base;
+            }
+        }
+        where += 31;
+    }
+    return 0;
+}
+
+/* Sharing of relocated RELRO segments between processes.
+ *
+ * When LD_RELRO_CACHE=<dir> is set, the PT_GNU_RELRO pages of a library
+ * are saved to <dir>/<library>.relro once it has been relocated, and the
+ * private copy is replaced with a read-only mapping of that file. A later
+ * process that loads the same library file at the same base address, with
+ * the same set of objects to resolve symbols against, maps the file
+ * instead, and skips every relocation that targets those pages. That
+ * saves both the relocation work and the dirty memory for them.
+ *
+ * The file starts with a relro_cache_header page, followed by the pages
+ * themselves. The header lists every object symbol lookups may resolve
+ * to, by load address and file identity, and has to match exactly.
+ */
+typedef struct {
+    unsigned base;
+    file_id file;
+} relro_scope_entry;
+
+#define RELRO_SCOPE_MAX ((PAGE_SIZE - 64) / sizeof(relro_scope_entry))
+
+typedef struct {
+    char magic[4];              /* 'R', 'L', 'R', '2' */
+    file_id file;               /* the library itself */
+    unsigned base;
+    unsigned relro_start;       /* relative to base */
+    unsigned relro_size;
+    unsigned scope_count;
+    relro_scope_entry scope[RELRO_SCOPE_MAX];
+} relro_cache_header;
+
+/* Only used under dl_lock; a page each is too much for a thread stack. */
+static relro_cache_header relro_want;
+static relro_cache_header relro_have;
+
+static int relro_cache_path(soinfo *si, char *buf, unsigned len)
+{
+    const char *name = strrchr(si->name, '/');
+
+    name = name ? name + 1 : si->name;
+    if (strlen(relro_cache_dir) + strlen(name) + 8 >= len)
+        return -1;
+    sprintf(buf, "%s/%s.relro", relro_cache_dir, name);
+    return 0;
+}
+
+/* Describe si and everything its symbol lookups may resolve to. Returns
+ * -1 if an object's file is unknown or the scope doesn't fit. */
+static int relro_cache_fill_header(soinfo *si, relro_cache_header *hdr)
+{
+    soinfo *trav;
+    unsigned n = 0;
+
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, "RLR2", 4);
+    hdr->file = si->file;
+    hdr->base = si->base;
+    hdr->relro_start = si->relro_start - si->base;
+    hdr->relro_size = si->relro_end - si->relro_start;
+
+    for (trav = solist; trav != NULL; trav = trav->next) {
+        if (trav->flags & FLAG_ERROR)
+            continue;
+        if (trav != &libdl_info && trav->file.ino == 0)
+            return -1;
+        if (n == RELRO_SCOPE_MAX)
+            return -1;
+        hdr->scope[n].base = trav->base;
+        hdr->scope[n].file = trav->file;
+        n++;
+    }
+    hdr->scope_count = n;
+    return 0;
+}
+
+/* Try to map a previously saved copy of si's relocated RELRO pages,
+ * described by relro_want. Returns 0 and sets FLAG_RELRO_SHARED on
+ * success. */
+static int relro_cache_map(soinfo *si)
+{
+    char path[512];
+    relro_cache_header *want = &relro_want;
+    relro_cache_header *have = &relro_have;
+    struct stat st;
+    void *p;
+    int fd;
+
+    if (relro_cache_path(si, path, sizeof(path)) < 0)
+        return -1;
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    /* A short file would still map, and fault later on first access. */
+    if (read(fd, have, sizeof(*have)) != sizeof(*have) ||
+        memcmp(want, have, sizeof(*want)) ||
+        fstat(fd, &st) < 0 ||
+        st.st_size < (off_t)(PAGE_SIZE + want->relro_size)) {
+        TRACE("[ %5d stale RELRO cache '%s' for '%s' ]\n",
+              pid, path, si->name);
+        close(fd);
+        return -1;
+    }
+
+    p = mmap((void *)si->relro_start, want->relro_size, PROT_READ,
+             MAP_PRIVATE | MAP_FIXED, fd, PAGE_SIZE);
+    close(fd);
+    if (p == MAP_FAILED) {
+        /* MAP_FIXED failed, so the old mapping is still in place */
+        WARN("%5d could not map RELRO cache '%s': %s\n",
+             pid, path, strerror(errno));
+        return -1;
+    }
+
+    TRACE("[ %5d mapped RELRO cache '%s' for '%s' @ 0x%08x (0x%08x) ]\n",
+          pid, path, si->name, si->relro_start, want->relro_size);
+    si->flags |= FLAG_RELRO_SHARED;
+    return 0;
+}
+
+/* Save si's freshly relocated RELRO pages under the relro_want header,
+ * then swap in a read-only mapping of the saved copy. Failures are not
+ * fatal. */
+static void relro_cache_store(soinfo *si)
+{
+    char path[512];
+    char tmp[512];
+    unsigned size = si->relro_end - si->relro_start;
+    void *p;
+    int fd;
+
+    if (relro_cache_path(si, path, sizeof(path)) < 0)
+        return;
+    if (strlen(path) + 12 >= sizeof(tmp))
+        return;
+    sprintf(tmp, "%s.%d", path, pid);
+
+    fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return;
+
+    if (write(fd, &relro_want, sizeof(relro_want)) != sizeof(relro_want) ||
+        lseek(fd, PAGE_SIZE, SEEK_SET) != PAGE_SIZE ||
+        write(fd, (void *)si->relro_start, size) != (int)size) {
+        WARN("%5d could not write RELRO cache '%s'\n", pid, tmp);
+        goto fail;
+    }
+
+    /* rename() is atomic, so readers never see a partial file */
+    if (rename(tmp, path) < 0)
+        goto fail;
+
+    p = mmap((void *)si->relro_start, size, PROT_READ,
+             MAP_PRIVATE | MAP_FIXED, fd, PAGE_SIZE);
+    if (p != MAP_FAILED) {
+        TRACE("[ %5d saved RELRO cache '%s' for '%s' ]\n",
+              pid, path, si->name);
+        si->flags |= FLAG_RELRO_SHARED;
+    }
+    close(fd);
+    return;
+
+fail:
+    close(fd);
+    unlink(tmp);
+}
+
+/* Lazy binding of PLT entries.
+ *
+ * When enabled, reloc_plt_lazy() leaves the JUMP_SLOT entries of the GOT
+ * pointing back into the PLT (they only get relocated by the load base),
+ * and stores the soinfo and the address of __linker_plt_resolve in GOT[1]
+ * and GOT[2]. The first call through a PLT entry then ends up in
+ * __linker_plt_resolve (see arch/<arch>/begin.S), which calls
+ * __linker_resolve_plt() to look the symbol up and patch the GOT entry,
+ * so that subsequent calls go straight to the target.
+ */
+extern void __linker_plt_resolve(void);
+
+#if defined(ANDROID_ARM_LINKER)
+#define R_JUMP_SLOT R_ARM_JUMP_SLOT
+#elif defined(ANDROID_X86_LINKER)
+#define R_JUMP_SLOT R_386_JUMP_SLOT
+#endif /* ANDROID_*_LINKER */
+
+static int reloc_plt_lazy(soinfo *si)
+{
+    Elf32_Rel *rel = si->plt_rel;
+    unsigned idx;
+
+    si->plt_got[1] = (unsigned)si;
+    si->plt_got[2] = (unsigned)&__linker_plt_resolve;
+
+    for (idx = 0; idx < si->plt_rel_count; ++idx, ++rel) {
+        if (ELF32_R_TYPE(rel->r_info) != R_JUMP_SLOT) {
+            if (reloc_library(si, rel, 1))
+                return -1;
+            continue;
+        }
+        MARK(rel->r_offset);
+        TRACE_TYPE(RELO, "%5d RELO LAZY %08x <- +%08x\n", pid,
+                   rel->r_offset + si->base, si->base);
+        *((unsigned *)(rel->r_offset + si->base)) += si->base;
+    }
+    return 0;
+}
+
+/* Called by __linker_plt_resolve with the soinfo from GOT[1] and the byte
+ * offset of the relocation in DT_JMPREL. Returns the resolved address. */
+unsigned __linker_resolve_plt(soinfo *si, unsigned rel_offset)
+{
+    Elf32_Rel *rel = (Elf32_Rel *)((char *)si->plt_rel + rel_offset);
+    const char *name =
+        si->strtab + si->symtab[ELF32_R_SYM(rel->r_info)].st_name;
+    unsigned *reloc = (unsigned *)(rel->r_offset + si->base);
+    Elf32_Sym *s;
+    unsigned base;
+    unsigned sym_addr = 0;
+    int token;
+
+    token = solist_read_begin();
+    s = _do_lookup_in_snapshot(token, si, name, &base);
+    if (s != NULL)
+        sym_addr = s->st_value + base;
+    solist_read_end(token);
+
+    if (s == NULL) {
+        ERROR("%5d cannot locate '%s' for lazy binding in '%s'\n",
+              pid, name, si->name);
+        exit(-1);
+    }
+
+    TRACE_TYPE(RELO, "%5d RELO LAZY %08x <- %08x %s\n", pid,
+               (unsigned)reloc, sym_addr, name);
+    *reloc = sym_addr;
+    return sym_addr;
+}
+
 static void call_array(unsigned *ctor, int count)
 {
     int n;
@@ -1320,6 +2147,9 @@ static int link_image(soinfo *si, unsigned wr_offset)
     unsigned *d;
     Elf32_Phdr *phdr = si->phdr;
     int phnum = si->phnum;
+    int use_relro_cache = (relro_cache_dir != NULL) &&
+                          (si->relro_end > si->relro_start) &&
+                          !(si->flags & (FLAG_EXE | FLAG_PRELINKED));
 
     INFO("[ %5d linking %s ]\n", pid, si->name);
     DEBUG("%5d si->base = 0x%08x si->flags = 0x%08x\n", pid,
@@ -1385,6 +2215,8 @@ static int link_image(soinfo *si, unsigned wr_offset)
                 si->dynamic = (unsigned *) (si->base + phdr->p_vaddr);
             }
         }
+        if (soaddr_insert(si) < 0)
+            goto fail;
     }
 
     if (si->dynamic == (unsigned *)-1) {
@@ -1404,6 +2236,23 @@ static int link_image(soinfo *si, unsigned wr_offset)
             si->bucket = (unsigned *) (si->base + *d + 8);
             si->chain = (unsigned *) (si->base + *d + 8 + si->nbucket * 4);
             break;
+        case DT_GNU_HASH:
+            /* nbucket, symndx, maskwords, shift2, bloom[maskwords],
+             * bucket[nbucket], chain[] */
+            si->gnu_nbucket = ((unsigned *) (si->base + *d))[0];
+            si->gnu_maskwords = ((unsigned *) (si->base + *d))[2];
+            si->gnu_shift2 = ((unsigned *) (si->base + *d))[3];
+            si->gnu_bloom_filter = (unsigned *) (si->base + *d + 16);
+            si->gnu_bucket = si->gnu_bloom_filter + si->gnu_maskwords;
+            si->gnu_chain = si->gnu_bucket + si->gnu_nbucket -
+                            ((unsigned *) (si->base + *d))[1];
+            if (si->gnu_nbucket == 0 || si->gnu_maskwords == 0 ||
+                (si->gnu_maskwords & (si->gnu_maskwords - 1)) != 0) {
+                ERROR("%5d invalid DT_GNU_HASH table in '%s'\n",
+                      pid, si->name);
+                goto fail;
+            }
+            break;
         case DT_STRTAB:
             si->strtab = (const char *) (si->base + *d);
             break;
@@ -1428,8 +2277,21 @@ static int link_image(soinfo *si, unsigned wr_offset)
         case DT_RELSZ:
             si->rel_count = *d / 8;
             break;
+        case DT_RELR:
+            si->relr = (unsigned *) (si->base + *d);
+            break;
+        case DT_RELRSZ:
+            si->relr_count = *d / 4;
+            break;
+        case DT_RELRENT:
+            if (*d != 4) {
+                ERROR("%5d unsupported DT_RELRENT %d in '%s'\n",
+                      pid, *d, si->name);
+                goto fail;
+            }
+            break;
         case DT_PLTGOT:
-            /* Save this in case we decide to do lazy binding. We don't yet. */
+            /* Needed for lazy binding (see reloc_plt_lazy()). */
             si->plt_got = (unsigned *)(si->base + *d);
             break;
         case DT_DEBUG:
@@ -1473,6 +2335,13 @@ static int link_image(soinfo *si, unsigned wr_offset)
         case DT_PREINIT_ARRAYSZ:
             si->preinit_array_count = ((unsigned)*d) / sizeof(Elf32_Addr);
             break;
+        case DT_BIND_NOW:
+            si->flags |= FLAG_BIND_NOW;
+            break;
+        case DT_FLAGS:
+            if (*d & DF_BIND_NOW)
+                si->flags |= FLAG_BIND_NOW;
+            break;
         case DT_TEXTREL:
             /* TODO: make use of this. */
             /* this means that we might have to write into where the text
@@ -1488,7 +2357,8 @@ static int link_image(soinfo *si, unsigned wr_offset)
     DEBUG("%5d si->base = 0x%08x, si->strtab = %p, si->symtab = %p\n", 
            pid, si->base, si->strtab, si->symtab);
 
-    if((si->strtab == 0) || (si->symtab == 0)) {
+    if((si->strtab == 0) || (si->symtab == 0) ||
+       ((si->bucket == 0) && (si->gnu_bucket == 0))) {
         ERROR("%5d missing essential tables\n", pid);
         goto fail;
     }
@@ -1505,20 +2375,52 @@ static int link_image(soinfo *si, unsigned wr_offset)
         }
     }
 
-    if(si->plt_rel) {
-        DEBUG("[ %5d relocating %s plt ]\n", pid, si->name );
-        if(reloc_library(si, si->plt_rel, si->plt_rel_count))
+    if (use_relro_cache) {
+        if (relro_cache_fill_header(si, &relro_want) < 0)
+            use_relro_cache = 0;
+        else
+            relro_cache_map(si);
+    }
+
+    if(si->relr) {
+        DEBUG("[ %5d relocating %s packed relative ]\n", pid, si->name );
+        if(reloc_relr(si, si->relr, si->relr_count))
             goto fail;
     }
+    alloc_symcache(si);
+    if(si->plt_rel) {
+        /* Prelinked libraries already have their GOT filled in with the
+         * final addresses, so they are always bound eagerly. So are
+         * libraries whose GOT may be shared through the RELRO cache. */
+        if(bind_lazy && si->plt_got && !use_relro_cache &&
+           !(si->flags & (FLAG_BIND_NOW | FLAG_PRELINKED))) {
+            DEBUG("[ %5d relocating %s plt (lazy) ]\n", pid, si->name );
+            if(reloc_plt_lazy(si))
+                goto fail;
+        } else {
+            DEBUG("[ %5d relocating %s plt ]\n", pid, si->name );
+            if(reloc_library(si, si->plt_rel, si->plt_rel_count))
+                goto fail;
+        }
+    }
     if(si->rel) {
         DEBUG("[ %5d relocating %s ]\n", pid, si->name );
         if(reloc_library(si, si->rel, si->rel_count))
             goto fail;
     }
+    free_symcache(si);
+
+    if (use_relro_cache && !(si->flags & FLAG_RELRO_SHARED))
+        relro_cache_store(si);
 
     si->flags |= FLAG_LINKED;
     DEBUG("[ %5d finished linking %s ]\n", pid, si->name);
 
+    /* Make the library visible to dlsym() (which may well be called
+     * from its constructors). */
+    if (publish_solist() < 0)
+        goto fail;
+
 #if 0
     /* This is the way that the old dynamic linker did protection of
      * non-writable areas. It would scan section headers and find where
@@ -1559,6 +2461,7 @@ static int link_image(soinfo *si, unsigned wr_offset)
 
 fail:
     ERROR("failed to link %s\n", si->name);
+    free_symcache(si);
     si->flags |= FLAG_ERROR;
     return -1;
 }
@@ -1598,14 +2501,28 @@ unsigned __linker_init(unsigned **elfdata)
     while(vecs[0] != 0) {
         if(!strncmp((char*) vecs[0], "DEBUG=", 6)) {
             debug_verbosity = atoi(((char*) vecs[0]) + 6);
+        } else if(!strncmp((char*) vecs[0], "LD_BIND_LAZY=", 13)) {
+            bind_lazy = atoi(((char*) vecs[0]) + 13);
+        } else if(!strncmp((char*) vecs[0], "LD_RELRO_CACHE=", 15)) {
+            relro_cache_dir = ((char*) vecs[0]) + 15;
+            if (*relro_cache_dir == 0)
+                relro_cache_dir = NULL;
         }
         vecs++;
     }
     vecs++;
 
+        /* don't let the environment change how setuid programs are bound */
+    if (getuid() != geteuid() || getgid() != getegid()) {
+        bind_lazy = 0;
+        relro_cache_dir = NULL;
+    }
+
     INFO("[ android linker & debugger ]\n");
     DEBUG("%5d elfdata @ 0x%08x\n", pid, (unsigned)elfdata);
 
+    soname_hash_insert(&libdl_info);
+
     si = alloc_info(argv[0]);
     if(si == 0) {
         exit(-1);
@@ -1655,6 +2572,15 @@ unsigned __linker_init(unsigned **elfdata)
     si->wrprotect_start = 0xffffffff;
     si->wrprotect_end = 0;
 
+        /* the executable is part of every library's symbol scope */
+    if (relro_cache_dir != NULL) {
+        int fd = open("/proc/self/exe", O_RDONLY);
+        if (fd >= 0) {
+            get_file_id(fd, &si->file);
+            close(fd);
+        }
+    }
+
     if(link_image(si, 0)){
         ERROR("CANNOT LINK EXECUTABLE '%s'\n", argv[0]);
         exit(-1);
@@ -1668,11 +2594,14 @@ unsigned __linker_init(unsigned **elfdata)
                ));
 #endif
 #if STATS
-    PRINT("RELO STATS: %s: %d abs, %d rel, %d copy, %d symbol\n", argv[0],
+    PRINT("RELO STATS: %s: %d abs, %d rel, %d copy, %d symbol "
+          "(%d cache hits, %d misses)\n", argv[0],
            linker_stats.reloc[RELOC_ABSOLUTE],
            linker_stats.reloc[RELOC_RELATIVE],
            linker_stats.reloc[RELOC_COPY],
-           linker_stats.reloc[RELOC_SYMBOL]);
+           linker_stats.reloc[RELOC_SYMBOL],
+           linker_stats.reloc[RELOC_SYMCACHE_HIT],
+           linker_stats.reloc[RELOC_SYMCACHE_MISS]);
 #endif
 #if COUNT_PAGES
     {
@@ -52,10 +52,26 @@ struct r_debug
 
 typedef struct soinfo soinfo;
 
+/* Identifies a library file, ino == 0 when unknown */
+typedef struct {
+    unsigned dev;
+    unsigned ino;
+    unsigned size;
+    unsigned mtime;
+} file_id;
+
+/* One resolved symbol, as remembered while relocating a library. */
+typedef struct {
+    Elf32_Sym *s;
+    unsigned base;
+} symcache_entry;
+
 #define FLAG_LINKED     0x00000001
 #define FLAG_ERROR      0x00000002
 #define FLAG_EXE        0x00000004 // The main executable
 #define FLAG_PRELINKED  0x00000008 // This is a pre-linked lib
+#define FLAG_BIND_NOW   0x00000010 // DT_BIND_NOW / DF_BIND_NOW, never lazy
+#define FLAG_RELRO_SHARED 0x00000020 // RELRO pages mapped from the cache
 
 #define SOINFO_NAME_LEN 128
 
@@ -76,6 +92,9 @@ struct soinfo
     soinfo *next;
     unsigned flags;
 
+    /* next soinfo with the same name hash (see find_library()) */
+    soinfo *hash_next;
+
     const char *strtab;
     Elf32_Sym *symtab;
 
@@ -84,6 +103,17 @@ struct soinfo
     unsigned *bucket;
     unsigned *chain;
 
+    /* GNU-style hash table (DT_GNU_HASH). When present, it is used in
+     * preference to the SysV one above. gnu_chain is pre-biased by the
+     * index of the first hashed symbol, so it can be indexed directly
+     * with a symbol index. */
+    unsigned gnu_nbucket;
+    unsigned gnu_maskwords;
+    unsigned gnu_shift2;
+    unsigned *gnu_bloom_filter;
+    unsigned *gnu_bucket;
+    unsigned *gnu_chain;
+
     unsigned *plt_got;
 
     Elf32_Rel *plt_rel;
@@ -92,6 +122,15 @@ struct soinfo
     Elf32_Rel *rel;
     unsigned rel_count;
 
+    /* Packed relative relocations (DT_RELR). */
+    unsigned *relr;
+    unsigned relr_count;
+
+    /* Resolved symbols, indexed by symbol number. Only valid while the
+     * library is being relocated in link_image(). */
+    symcache_entry *symcache;
+    unsigned symcache_size;
+
     unsigned *preinit_array;
     unsigned preinit_array_count;
 
@@ -103,6 +142,12 @@ struct soinfo
     void (*init_func)(void);
     void (*fini_func)(void);
 
+    /* Page-aligned part of PT_GNU_RELRO, and the identity of the file
+     * the object was loaded from (see relro_cache_map() in linker.c). */
+    unsigned relro_start;
+    unsigned relro_end;
+    file_id file;
+
 #ifdef ANDROID_ARM_LINKER
     /* ARM EABI section used for stack unwinding. */
     unsigned *ARM_exidx;
@@ -140,6 +185,10 @@ extern soinfo libdl_info;
 #endif /* ANDROID_*_LINKER */
 
 
+#ifndef DT_BIND_NOW
+#define DT_BIND_NOW        24
+#endif
+
 #ifndef DT_INIT_ARRAY
 #define DT_INIT_ARRAY      25
 #endif
@@ -156,6 +205,14 @@ extern soinfo libdl_info;
 #define DT_FINI_ARRAYSZ    28
 #endif
 
+#ifndef DT_FLAGS
+#define DT_FLAGS           30
+#endif
+
+#ifndef DF_BIND_NOW
+#define DF_BIND_NOW        0x00000008
+#endif
+
 #ifndef DT_PREINIT_ARRAY
 #define DT_PREINIT_ARRAY   32
 #endif
@@ -164,6 +221,22 @@ extern soinfo libdl_info;
 #define DT_PREINIT_ARRAYSZ 33
 #endif
 
+#ifndef DT_RELRSZ
+#define DT_RELRSZ          35
+#endif
+
+#ifndef DT_RELR
+#define DT_RELR            36
+#endif
+
+#ifndef DT_RELRENT
+#define DT_RELRENT         37
+#endif
+
+#ifndef DT_GNU_HASH
+#define DT_GNU_HASH        0x6ffffef5
+#endif
+
 /* in theory we only need the above relative relocations,
    but in practice the following one turns up from time
    to time.  fushigi na.
@@ -173,7 +246,9 @@ extern soinfo libdl_info;
 soinfo *find_library(const char *name);
 unsigned unload_library(soinfo *si);
 Elf32_Sym *lookup_in_library(soinfo *si, const char *name);
-Elf32_Sym *lookup(const char *name, unsigned *base);
+Elf32_Sym *lookup(int token, const char *name, unsigned *base);
+int solist_read_begin(void);
+void solist_read_end(int token);
 
 #ifdef ANDROID_ARM_LINKER 
 typedef long unsigned int *_Unwind_Ptr;
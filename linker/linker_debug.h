@@ -65,7 +65,9 @@ extern int debug_verbosity;
 #define RELOC_RELATIVE        1
 #define RELOC_COPY            2
 #define RELOC_SYMBOL          3
-#define NUM_RELOC_STATS       4
+#define RELOC_SYMCACHE_HIT    4
+#define RELOC_SYMCACHE_MISS   5
+#define NUM_RELOC_STATS       6
 
 struct _link_stats {
     int reloc[NUM_RELOC_STATS];